@@ -4,6 +4,7 @@
 #include "SigmaSymbol.h"
 #include "IndexSymbol.h"
 #include <typeinfo>
+#include <exception>
 #include "instruments.h"
 #include <assert.h>
 #include <windowsx.h>
@@ -893,8 +894,6 @@ void CEditWindow::insertTwoParametrFunc( wchar_t funcName, wchar_t firstParametr
 
 bool CEditWindow::writeSelectedInFile( LPWSTR fileName, int fileExtentionPos ) const
 {
-	HANDLE file = ::CreateFile( fileName, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
-		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
 	CLineOfSymbols tmp( simpleSymbolHeight );
 	CItemSelector::CSymbolInterval selectedInterval = symbolSelector.GetSelectionInfo();
 	CSymbolPosition start = selectedInterval.first;
@@ -909,13 +908,21 @@ bool CEditWindow::writeSelectedInFile( LPWSTR fileName, int fileExtentionPos ) c
 	} else if( fileName + fileExtentionPos == std::wstring( L"mml" ) ) {
 		format = SF_MATHML;
 	}
+	if( format != SF_LATEX ) {
+		// Конвертируем в памяти, чтобы не писать Latex в файл и не перечитывать его
+		std::string latexString;
+		latexString.swap( outputString );
+		try {
+			ConvertFormulaText( latexString, SF_LATEX, format, outputString );
+		} catch( const std::exception& ) {
+			// Формулу нельзя записать в этом формате (например, \sin в MathML)
+			return false;
+		}
+	}
+	HANDLE file = ::CreateFile( fileName, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
 	DWORD countBytes = 0;
 	::WriteFile( file, outputString.c_str(), outputString.size(), &countBytes, 0 );
 	::CloseHandle( file );
-	if( format != SF_LATEX ) {
-		std::wstring input( fileName );
-		std::string inputAsString( input.begin(), input.end() );
-		ConvertFormula( inputAsString, SF_LATEX, format, inputAsString );
-	}
 	return outputString.size() == countBytes;
 }
\ No newline at end of file
@@ -0,0 +1,366 @@
+﻿// Описание: Реализация пакетной конвертации формул
+
+#include "BatchConverter.h"
+#include "ConvertLatex.h"
+#include "ConvertOM.h"
+#include "MathML.h"
+#include "MathTree.h"
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+double getTime()
+{
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+	::QueryPerformanceCounter( &counter );
+	::QueryPerformanceFrequency( &frequency );
+	return static_cast<double>( counter.QuadPart ) / frequency.QuadPart;
+}
+
+// Все, что нужно одному потоку пакета. Конвертеры и таблицы OpenMath создаются один раз на поток,
+// а не на каждую формулу, и не разделяются между потоками
+class CBatchWorker {
+public:
+	CBatchWorker( TSupportedFormats inputFormat, TSupportedFormats outputFormat, bool singleLine );
+
+	// Берет формулы из items по счетчику next, пока они не кончатся
+	void Run( vector<CBatchItem>* items, atomic<size_t>* next );
+
+	CBatchStats ReadStats;
+	CBatchStats WriteStats;
+
+private:
+	TSupportedFormats inputFormat;
+	TSupportedFormats outputFormat;
+	bool singleLine;
+	CConvertLatex latexConverter;
+	IdCollection ids;
+	AttrCollection attrs;
+	CMathTree tree;
+
+	void read( const string& input );
+	void write( string& output );
+	// Выполняет этап и считает его статистику. Возвращает false, если этап бросил исключение
+	template<class TStage>
+	bool runStage( TStage stage, CBatchStats& stats, CBatchItem& item );
+};
+
+CBatchWorker::CBatchWorker( TSupportedFormats _inputFormat, TSupportedFormats _outputFormat, bool _singleLine ) :
+	inputFormat( _inputFormat ),
+	outputFormat( _outputFormat ),
+	singleLine( _singleLine )
+{
+	if( inputFormat == SF_OPENMATH ) {
+		LoadIdTable( &ids );
+	}
+	if( outputFormat == SF_OPENMATH ) {
+		LoadAttrTable( &attrs );
+	}
+}
+
+void CBatchWorker::read( const string& input )
+{
+	tree.Clear();
+	switch( inputFormat ) {
+		case SF_LATEX:
+			latexConverter.ConvertFromLatex( input, tree );
+			break;
+		case SF_MATHML:
+		{
+			MathMLParser mmlparser;
+			mmlparser.ParsString( input );
+			tree.Assign( mmlparser.GetData() );
+			break;
+		}
+		case SF_OPENMATH:
+		{
+			shared_ptr<FormulaObj> obj( new FormulaObj( NT_MAIN ) );
+			ConvertFromOMString( &ids, input, obj );
+			tree.Assign( obj );
+			break;
+		}
+	}
+}
+
+void CBatchWorker::write( string& output )
+{
+	output.clear();
+	switch( outputFormat ) {
+		case SF_LATEX:
+			latexConverter.ConvertToLatex( tree, output );
+			break;
+		case SF_MATHML:
+			MathMLParser::SaveToString( tree, output, singleLine );
+			break;
+		case SF_OPENMATH:
+			ConvertToOMString( &attrs, tree, output, singleLine );
+			break;
+	}
+}
+
+template<class TStage>
+bool CBatchWorker::runStage( TStage stage, CBatchStats& stats, CBatchItem& item )
+{
+	double start = getTime();
+	try {
+		stage();
+	} catch( const exception& e ) {
+		item.Error = e.what();
+	} catch( ... ) {
+		item.Error = "Unknown error";
+	}
+	stats.Seconds += getTime() - start;
+	++stats.Count;
+
+	if( item.Error.empty() ) {
+		return true;
+	}
+	++stats.Errors;
+	item.Failed = true;
+	item.Output.clear();
+	return false;
+}
+
+void CBatchWorker::Run( vector<CBatchItem>* items, atomic<size_t>* next )
+{
+	for( size_t i = ( *next )++; i < items->size(); i = ( *next )++ ) {
+		CBatchItem& item = ( *items )[i];
+		if( item.Input.empty() ) {
+			continue;
+		}
+		if( runStage( [&]() { read( item.Input ); }, ReadStats, item ) ) {
+			runStage( [&]() { write( item.Output ); }, WriteStats, item );
+		}
+	}
+}
+
+void printStageReport( const char* formatName, const char* stageName, const CBatchStats& stats, ostream& report )
+{
+	report << formatName << ' ' << stageName << ": " << stats.Count << " formulas, " << stats.Errors << " errors";
+	if( stats.Seconds > 0 ) {
+		// Скорость одного потока: время этапа просуммировано по всем потокам
+		report << ", " << static_cast<long long>( stats.Count / stats.Seconds ) << " formulas/sec per thread";
+	}
+	report << endl;
+}
+
+} // namespace
+
+void CBatchStats::Add( const CBatchStats& other )
+{
+	Count += other.Count;
+	Errors += other.Errors;
+	Seconds += other.Seconds;
+}
+
+CBatchConverter::CBatchConverter( TSupportedFormats _inputFormat, TSupportedFormats _outputFormat, bool _singleLine ) :
+	inputFormat( _inputFormat ),
+	outputFormat( _outputFormat ),
+	singleLine( _singleLine ),
+	seconds( 0 )
+{
+}
+
+void CBatchConverter::Convert( vector<CBatchItem>& items, int threadsCount )
+{
+	double start = getTime();
+	if( threadsCount <= 0 ) {
+		threadsCount = max( 1, static_cast<int>( thread::hardware_concurrency() ) );
+	}
+	threadsCount = max( 1, min( threadsCount, static_cast<int>( items.size() ) ) );
+
+	vector< unique_ptr<CBatchWorker> > workers;
+	for( int i = 0; i < threadsCount; ++i ) {
+		workers.push_back( unique_ptr<CBatchWorker>( new CBatchWorker( inputFormat, outputFormat, singleLine ) ) );
+	}
+
+	atomic<size_t> next( 0 );
+	if( threadsCount == 1 ) {
+		workers[0]->Run( &items, &next );
+	} else {
+		vector<thread> threads;
+		for( int i = 0; i < threadsCount; ++i ) {
+			threads.push_back( thread( &CBatchWorker::Run, workers[i].get(), &items, &next ) );
+		}
+		for( size_t i = 0; i < threads.size(); ++i ) {
+			threads[i].join();
+		}
+	}
+
+	readStats = CBatchStats();
+	writeStats = CBatchStats();
+	for( size_t i = 0; i < workers.size(); ++i ) {
+		readStats.Add( workers[i]->ReadStats );
+		writeStats.Add( workers[i]->WriteStats );
+	}
+	seconds = getTime() - start;
+}
+
+void CBatchConverter::PrintReport( const vector<CBatchItem>& items, ostream& report ) const
+{
+	for( size_t i = 0; i < items.size(); ++i ) {
+		if( items[i].Failed ) {
+			report << items[i].Name << ": " << items[i].Error << endl;
+		}
+	}
+
+	printStageReport( GetFormatName( inputFormat ), "read", readStats, report );
+	printStageReport( GetFormatName( outputFormat ), "write", writeStats, report );
+	int errors = readStats.Errors + writeStats.Errors;
+	report << "total: " << readStats.Count << " formulas, " << errors << " errors, " << seconds << " sec";
+	if( seconds > 0 ) {
+		report << ", " << static_cast<long long>( readStats.Count / seconds ) << " formulas/sec";
+	}
+	report << endl;
+}
+
+const char* GetFormatName( TSupportedFormats format )
+{
+	switch( format ) {
+		case SF_LATEX:
+			return "latex";
+		case SF_MATHML:
+			return "mathml";
+		case SF_OPENMATH:
+			return "omath";
+	}
+	return "";
+}
+
+bool ParseFormatName( const string& name, TSupportedFormats& format )
+{
+	const TSupportedFormats formats[] = { SF_LATEX, SF_MATHML, SF_OPENMATH };
+	for( size_t i = 0; i < sizeof( formats ) / sizeof( formats[0] ); ++i ) {
+		if( name == GetFormatName( formats[i] ) ) {
+			format = formats[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* GetFormatExtension( TSupportedFormats format )
+{
+	switch( format ) {
+		case SF_LATEX:
+			return "tex";
+		case SF_MATHML:
+			return "mml";
+		case SF_OPENMATH:
+			return "xml";
+	}
+	return "";
+}
+
+bool ReadBatchLines( const string& fileName, vector<CBatchItem>& items )
+{
+	ifstream ifs( fileName );
+	if( !ifs ) {
+		return false;
+	}
+	string line;
+	for( int lineNumber = 1; getline( ifs, line ); ++lineNumber ) {
+		if( !line.empty() && line[line.length() - 1] == '\r' ) {
+			line.erase( line.length() - 1 );
+		}
+		items.push_back( CBatchItem() );
+		items.back().Name = "line " + to_string( lineNumber );
+		items.back().Input.swap( line );
+	}
+	return !ifs.bad();
+}
+
+bool ReadBatchDirectory( const string& directory, vector<CBatchItem>& items )
+{
+	vector<string> names;
+	WIN32_FIND_DATAA findData;
+	HANDLE find = ::FindFirstFileA( ( directory + "\\*" ).c_str(), &findData );
+	if( find == INVALID_HANDLE_VALUE ) {
+		return false;
+	}
+	do {
+		if( ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) == 0 ) {
+			names.push_back( findData.cFileName );
+		}
+	} while( ::FindNextFileA( find, &findData ) );
+	::FindClose( find );
+
+	sort( names.begin(), names.end() );
+	bool isRead = true;
+	for( size_t i = 0; i < names.size(); ++i ) {
+		ifstream ifs( directory + "\\" + names[i] );
+		isRead = isRead && ifs.is_open();
+		items.push_back( CBatchItem() );
+		items.back().Name = names[i];
+		items.back().Input.assign( istreambuf_iterator<char>( ifs ), istreambuf_iterator<char>() );
+	}
+	return isRead;
+}
+
+bool WriteBatchLines( const string& fileName, const vector<CBatchItem>& items )
+{
+	ofstream ofs( fileName, ios::out );
+	for( size_t i = 0; i < items.size(); ++i ) {
+		ofs << items[i].Output << '\n';
+	}
+	ofs.close();
+	return !ofs.fail();
+}
+
+bool WriteBatchDirectory( const string& directory, TSupportedFormats format, const vector<CBatchItem>& items )
+{
+	// Папка может уже существовать, ошибки записи проверяются по самим файлам
+	::CreateDirectoryA( directory.c_str(), 0 );
+	bool isWritten = true;
+	for( size_t i = 0; i < items.size(); ++i ) {
+		if( items[i].Failed || items[i].Input.empty() ) {
+			continue;
+		}
+		string name = items[i].Name;
+		size_t dot = name.rfind( '.' );
+		if( dot != string::npos ) {
+			name.erase( dot );
+		}
+		ofstream ofs( directory + "\\" + name + "." + GetFormatExtension( format ), ios::out );
+		ofs << items[i].Output;
+		ofs.close();
+		isWritten = isWritten && !ofs.fail();
+	}
+	return isWritten;
+}
+
+int ConvertBatch( const string& input, TSupportedFormats inputFormat, TSupportedFormats outputFormat,
+	const string& output, ostream& report, int threadsCount )
+{
+	DWORD attributes = ::GetFileAttributesA( input.c_str() );
+	bool isDirectory = attributes != INVALID_FILE_ATTRIBUTES && ( attributes & FILE_ATTRIBUTE_DIRECTORY ) != 0;
+
+	vector<CBatchItem> items;
+	bool isRead = isDirectory ? ReadBatchDirectory( input, items ) : ReadBatchLines( input, items );
+	if( !isRead ) {
+		report << input << ": cannot read input" << endl;
+		return -1;
+	}
+
+	// В файле результат каждой формулы должен занимать одну строку
+	CBatchConverter converter( inputFormat, outputFormat, !isDirectory );
+	converter.Convert( items, threadsCount );
+
+	bool isWritten = isDirectory ? WriteBatchDirectory( output, outputFormat, items ) : WriteBatchLines( output, items );
+	converter.PrintReport( items, report );
+	if( !isWritten ) {
+		report << output << ": cannot write output" << endl;
+		return -1;
+	}
+	return converter.GetReadStats().Errors + converter.GetWriteStats().Errors;
+}
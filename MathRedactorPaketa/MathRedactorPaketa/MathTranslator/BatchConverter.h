@@ -0,0 +1,80 @@
+﻿// Описание: Пакетная конвертация большого числа формул на пуле потоков.
+// Каждый поток один раз создает свои конвертеры и таблицы OpenMath и берет формулы по одной из общего счетчика.
+// Результаты пишутся в сами элементы пакета, поэтому выводятся в порядке входа
+
+#pragma once
+
+#include "TranslatorDLLInterface.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Одна формула пакета
+struct CBatchItem {
+	std::string Name; // Номер строки или имя файла, для сообщений об ошибках
+	std::string Input;
+	std::string Output;
+	std::string Error; // Пустая, если формула сконвертирована
+	bool Failed;
+
+	CBatchItem() : Failed( false ) {}
+};
+
+// Статистика одного этапа: разбора входного формата или записи выходного
+struct CBatchStats {
+	int Count;
+	int Errors;
+	double Seconds; // Суммарное время этапа во всех потоках
+
+	CBatchStats() : Count( 0 ), Errors( 0 ), Seconds( 0 ) {}
+
+	void Add( const CBatchStats& other );
+};
+
+class CBatchConverter {
+public:
+	// singleLine - писать XML без переносов строк, чтобы каждый результат занимал одну строку
+	CBatchConverter( TSupportedFormats inputFormat, TSupportedFormats outputFormat, bool singleLine );
+
+	// Конвертирует все формулы на threadsCount потоках (0 - по числу ядер).
+	// Ошибка в одной формуле записывается в ее элемент и не прерывает пакет. Пустые формулы пропускаются
+	void Convert( std::vector<CBatchItem>& items, int threadsCount = 0 );
+
+	const CBatchStats& GetReadStats() const { return readStats; }
+	const CBatchStats& GetWriteStats() const { return writeStats; }
+	double GetSeconds() const { return seconds; }
+
+	// Печатает ошибки по каждой формуле и скорость по форматам
+	void PrintReport( const std::vector<CBatchItem>& items, std::ostream& report ) const;
+
+private:
+	TSupportedFormats inputFormat;
+	TSupportedFormats outputFormat;
+	bool singleLine;
+	CBatchStats readStats;
+	CBatchStats writeStats;
+	double seconds; // Время всего пакета
+};
+
+// Название формата, как в параметрах MTConvert: latex, mathml, omath
+const char* GetFormatName( TSupportedFormats format );
+// Формат по названию. Возвращает false, если такого формата нет
+bool ParseFormatName( const std::string& name, TSupportedFormats& format );
+// Расширение файлов формата, как при сохранении в редакторе: tex, mml, xml
+const char* GetFormatExtension( TSupportedFormats format );
+
+// Формулы из файла, по одной на строку. Возвращает false, если файл не удалось прочитать
+bool ReadBatchLines( const std::string& fileName, std::vector<CBatchItem>& items );
+// Формулы из папки, по одной на файл, в порядке имен файлов. Возвращает false, если папку или один из файлов не удалось прочитать
+bool ReadBatchDirectory( const std::string& directory, std::vector<CBatchItem>& items );
+// Результаты в файл, по одному на строку. На месте неудачных формул остаются пустые строки.
+// Возвращает false, если файл не удалось записать
+bool WriteBatchLines( const std::string& fileName, const std::vector<CBatchItem>& items );
+// Результаты в папку, по файлу на формулу с тем же именем и расширением выходного формата.
+// Возвращает false, если хотя бы один файл не удалось записать
+bool WriteBatchDirectory( const std::string& directory, TSupportedFormats format, const std::vector<CBatchItem>& items );
+
+// Конвертирует файл с формулами по одной на строку или папку с файлами формул в файл или папку output.
+// Возвращает число формул, которые не удалось сконвертировать, или -1, если не удалось прочитать вход или записать результат
+int ConvertBatch( const std::string& input, TSupportedFormats inputFormat, TSupportedFormats outputFormat,
+	const std::string& output, std::ostream& report, int threadsCount = 0 );
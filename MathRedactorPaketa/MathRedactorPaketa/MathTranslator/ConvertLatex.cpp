@@ -3,111 +3,65 @@
 
 #include "ConvertLatex.h"
 #include <assert.h>
+#include <limits.h>
 #include <iostream>
+#include <stdexcept>
 
 using namespace std;
 
-shared_ptr<MathObj> CConvertLatex::ConvertFromLatex( const string& input )
+void CConvertLatex::ConvertFromLatex( const string& input, CMathTree& tree )
 {
-	parser.Init();
+	ConvertFromLatex( input.data(), static_cast<int>( input.length() ), tree );
+}
 
-	// Стартовое состояние лексера - TT_SPACE, т.к. оно игнорируется парсером и принимает любые символы
-	shared_ptr<CLatexState> state (new CLatexSingleState( TT_SPACE ));
+void CConvertLatex::ConvertFromLatex( const char* input, int length, CMathTree& tree )
+{
+	lexer.Init( input, length );
+	parser.Init( input, &tree );
 
-	for( int i = 0; i < static_cast<int>( input.length( ) ); ++i ) {
-		shared_ptr<CLatexState> nextState = state->Accept( input[i] );
-		parser.TryParse( state );
-		state = nextState;
+	for( CLatexToken token = lexer.Next(); token.Type != TT_EOF; token = lexer.Next() ) {
+		parser.Parse( token );
 	}
 
-	// Символы в строке закончились, поэтому нужно отсоединить последний токен и протолкнуть в парсер
-	state->Detach();
-	parser.TryParse( state );
-
-	shared_ptr<MathObj> root = parser.End();
-	return root;
+	// Символы в строке закончились, проталкиваем EOF
+	parser.End();
 }
 
-void CConvertLatex::ConvertToLatex( shared_ptr<MathObj> moTree, string& output ) const
+shared_ptr<MathObj> CConvertLatex::ConvertFromLatex( const string& input )
 {
-	FormulaObj* fobj = dynamic_cast<FormulaObj*>( moTree.get() );
-	assert( fobj != 0 );
-	assert( fobj->GetType() == NT_MAIN );
-	writeNode( fobj->params[0], output );
+	CMathTree tree;
+	ConvertFromLatex( input, tree );
+	return tree.ToMathObj();
 }
 
-void CConvertLatex::writeNode( shared_ptr<MathObj> node, string& output ) const
+void CConvertLatex::ConvertToLatex( shared_ptr<MathObj> moTree, string& output ) const
 {
-	shared_ptr<FormulaObj> fobj = dynamic_pointer_cast<FormulaObj>( node );
-	if( fobj == 0 ) {
-		// ParamObj, выводим ID
-		shared_ptr<ParamObj> pobj = dynamic_pointer_cast<ParamObj>( node );
-		assert( pobj != 0 );
-		output += pobj->GetVal();
-		return;
-	}
-
-	switch( fobj->GetType() )  
-	{
-		case NT_MULTCM:
-			return writeBinop( fobj, output );
-		case NT_PLUS:
-			return writeBinop( fobj, output );
-		case NT_MINUS:
-			return writeBinop( fobj, output );
-		case NT_DIV:
-			return writeDiv( fobj, output );
-		case NT_POW:
-			return writePow( fobj, output );
-		case NT_ROOT:
-			return writeRoot( fobj, output );
-		case NT_SUM:
-			return writeSumOrProd( fobj, output );
-		case NT_PROD:
-			return writeSumOrProd( fobj, output );
-		case NT_SIN:
-			return writeTrigon( fobj, output );
-		case NT_COS:
-			return writeTrigon( fobj, output );
-		case NT_TAN:
-			return writeTrigon( fobj, output );
-		case NT_COT:
-			return writeTrigon( fobj, output );
-		case NT_UMINUS:
-			return writeUMinus( fobj, output );
-		default:
-			assert( false );
-	}
+	CMathTree tree;
+	tree.Assign( moTree );
+	ConvertToLatex( tree, output );
 }
 
-int CConvertLatex::priority( shared_ptr<MathObj> node )
-{
-	FormulaObj* fobj = dynamic_cast<FormulaObj*>( node.get() );
-	if( fobj == 0 ) {
-		// ID
-		return INT_MAX;
-	}
+namespace {
 
-	switch( fobj->GetType() )  
+// Приоритет операции для расстановки скобок
+int latexPriority( const CMathTree& tree, int node )
+{
+	switch( tree.GetType( node ) )
 	{
+		case NT_PARAM:
+			return INT_MAX;
 		case NT_PLUS:
-			return 0;
 		case NT_MINUS:
 			return 0;
 		case NT_SUM:
-			return 1;
 		case NT_PROD:
 			return 1;
 		case NT_SIN:
-			return 2;
 		case NT_COS:
-			return 2;
 		case NT_TAN:
-			return 2;
 		case NT_COT:
 			return 2;
 		case NT_MULTCM:
-			return 3;
 		case NT_DIV:
 			return 3;
 		case NT_UMINUS:
@@ -117,127 +71,206 @@ int CConvertLatex::priority( shared_ptr<MathObj> node )
 		case NT_ROOT:
 			return INT_MAX;
 		default:
-			assert( false );
+			// Неподдерживаемая операция, ее отвергнет EnterFormula
+			return INT_MAX;
 	}
-
-	return 0;
 }
 
-void CConvertLatex::writeChild( shared_ptr<MathObj> parent, shared_ptr<MathObj> child, string& output ) const
+// Обход дерева, записывающий формулу в Latex
+class CLatexWriter : public CMathTreeVisitor {
+public:
+	explicit CLatexWriter( string& _output ) : output( _output ) {}
+
+	virtual void VisitParam( const CMathTree& tree, int node );
+	virtual bool EnterFormula( const CMathTree& tree, int node );
+	virtual void LeaveFormula( const CMathTree& tree, int node );
+	virtual bool BeforeChild( const CMathTree& tree, int parent, int index );
+	virtual void AfterChild( const CMathTree& tree, int parent, int index );
+
+private:
+	string& output;
+
+	// Сколько потомков выводится, остальные пропускаются
+	static int writtenChildren( const CMathTree& tree, int node );
+	// Нужны ли скобки вокруг потомка: операнды бинарных операций, основание степени и аргумент
+	// унарного минуса берутся в скобки, если приоритет потомка ниже
+	static bool needBraces( const CMathTree& tree, int parent, int index );
+};
+
+void CLatexWriter::VisitParam( const CMathTree& tree, int node )
 {
-	if( priority( child ) < priority( parent ) ) {
-		output += '(';
-		writeNode( child, output );
-		output += ')';
-	} else {
-		writeNode( child, output );
-	}
+	output.append( tree.GetValue( node ), tree.GetValueLength( node ) );
 }
 
-void CConvertLatex::writeBinop( shared_ptr<FormulaObj> node, string& output ) const
+bool CLatexWriter::EnterFormula( const CMathTree& tree, int node )
 {
-	writeChild( node, node->params[0], output );
-
-	switch( node->GetType() )  
+	switch( tree.GetType( node ) )
 	{
 		case NT_MULTCM:
-			output += '*';
-			break;
 		case NT_PLUS:
-			output += '+';
-			break;
 		case NT_MINUS:
+		case NT_POW:
+			return true;
+		case NT_DIV:
+			output += "\\frac{";
+			return true;
+		case NT_ROOT:
+			output += "\\sqrt{";
+			return true;
+		case NT_SUM:
+			output += "\\sum_{";
+			return true;
+		case NT_PROD:
+			output += "\\prod_{";
+			return true;
+		case NT_SIN:
+			output += "\\sin(";
+			return true;
+		case NT_COS:
+			output += "\\cos(";
+			return true;
+		case NT_TAN:
+			output += "\\tan(";
+			return true;
+		case NT_COT:
+			output += "\\cot(";
+			return true;
+		case NT_UMINUS:
 			output += '-';
-			break;
+			return true;
 		default:
-			assert( false );
+			throw invalid_argument( "Operation is not supported in Latex" );
 	}
-
-	writeChild( node, node->params[1], output );
 }
 
-void CConvertLatex::writeDiv( shared_ptr<FormulaObj> node, string& output ) const
+void CLatexWriter::LeaveFormula( const CMathTree& tree, int node )
 {
-	assert( node->GetType() == NT_DIV );
-
-	output += "\\frac{";
-	writeNode( node->params[0], output );
-	output += "}{";
-	writeNode( node->params[1], output );
-	output += '}';
+	switch( tree.GetType( node ) )
+	{
+		case NT_DIV:
+		case NT_POW:
+		case NT_ROOT:
+			output += '}';
+			break;
+		case NT_SUM:
+		case NT_PROD:
+		case NT_SIN:
+		case NT_COS:
+		case NT_TAN:
+		case NT_COT:
+			output += ')';
+			break;
+		default:
+			break;
+	}
 }
 
-void CConvertLatex::writePow( shared_ptr<FormulaObj> node, string& output ) const
+int CLatexWriter::writtenChildren( const CMathTree& tree, int node )
 {
-	assert( node->GetType() == NT_POW );
-
-	writeChild( node, node->params[0], output );
-
-	output += "^{";
-	writeNode( node->params[1], output );
-	output += '}';
+	switch( tree.GetType( node ) )
+	{
+		case NT_ROOT:
+		case NT_SIN:
+		case NT_COS:
+		case NT_TAN:
+		case NT_COT:
+		case NT_UMINUS:
+			return 1;
+		case NT_DIV:
+		case NT_POW:
+			return 2;
+		case NT_SUM:
+		case NT_PROD:
+			return 3;
+		default:
+			// Бинарные операции, у MathML они бывают n-арными
+			return tree.GetChildrenCount( node );
+	}
 }
 
-void CConvertLatex::writeSumOrProd( shared_ptr<FormulaObj> node, string& output ) const
+bool CLatexWriter::needBraces( const CMathTree& tree, int parent, int index )
 {
-	switch( node->GetType() )  
+	switch( tree.GetType( parent ) )
 	{
-		case NT_SUM:
-			output += "\\sum_{";
+		case NT_MULTCM:
+		case NT_PLUS:
+		case NT_MINUS:
+		case NT_UMINUS:
 			break;
-		case NT_PROD:
-			output += "\\prod_{";
+		case NT_POW:
+			if( index != 0 ) {
+				return false;
+			}
 			break;
 		default:
-			assert( false );
+			return false;
 	}
+	return latexPriority( tree, tree.GetChild( parent, index ) ) < latexPriority( tree, parent );
+}
 
-	writeNode( node->params[0], output );
-	output += "}^{";
-	writeNode( node->params[1], output );
-	output += "}(";
-	writeNode( node->params[2], output );
-	output += ")";
+bool CLatexWriter::BeforeChild( const CMathTree& tree, int parent, int index )
+{
+	if( index >= writtenChildren( tree, parent ) ) {
+		return false;
+	}
+	if( needBraces( tree, parent, index ) ) {
+		output += '(';
+	}
+	return true;
 }
 
-void CConvertLatex::writeTrigon( shared_ptr<FormulaObj> node, string& output ) const
+void CLatexWriter::AfterChild( const CMathTree& tree, int parent, int index )
 {
-	switch( node->GetType() )  
+	if( needBraces( tree, parent, index ) ) {
+		output += ')';
+	}
+
+	bool isLast = index + 1 == writtenChildren( tree, parent );
+	switch( tree.GetType( parent ) )
 	{
-		case NT_SIN:
-			output += "\\sin(";
+		case NT_MULTCM:
+			if( !isLast ) {
+				output += '*';
+			}
 			break;
-		case NT_COS:
-			output += "\\cos(";
+		case NT_PLUS:
+			if( !isLast ) {
+				output += '+';
+			}
 			break;
-		case NT_TAN:
-			output += "\\tan(";
+		case NT_MINUS:
+			if( !isLast ) {
+				output += '-';
+			}
 			break;
-		case NT_COT:
-			output += "\\cot(";
+		case NT_DIV:
+			if( !isLast ) {
+				output += "}{";
+			}
+			break;
+		case NT_POW:
+			if( !isLast ) {
+				output += "^{";
+			}
+			break;
+		case NT_SUM:
+		case NT_PROD:
+			if( index == 0 ) {
+				output += "}^{";
+			} else if( index == 1 ) {
+				output += "}(";
+			}
 			break;
 		default:
-			assert( false );
+			break;
 	}
-
-	writeNode( node->params[0], output );
-	output += ')';
 }
 
-void CConvertLatex::writeUMinus( shared_ptr<FormulaObj> node, string& output ) const
-{
-	assert( node->GetType() == NT_UMINUS );
-
-	output += '-';
-
-	writeChild( node, node->params[0], output );
-}
+} // namespace
 
-void CConvertLatex::writeRoot(shared_ptr<FormulaObj> node, string& output) const  
+void CConvertLatex::ConvertToLatex( const CMathTree& tree, string& output ) const
 {
-	assert(node->GetType() == NT_ROOT);
-
-	output += "\\sqrt{";
-	writeNode(node->params[0], output);
-	output += "}";
+	assert( !tree.IsEmpty() );
+	CLatexWriter writer( output );
+	tree.Walk( writer );
 }
@@ -4,8 +4,10 @@
 #include "ConvertOM.h"
 #include "tinyxml.h"
 #include <iostream>
+#include <string.h>
 #include <string>
 #include <sstream>
+#include <stdexcept>
 #include <fstream>
 
 
@@ -69,6 +71,42 @@ void ConvertFromOM( std::string inputFileName, shared_ptr<MathObj> obj )
 
 	ConvertElemToObj(&ids, pElem, obj );
 }
+void ConvertFromOMString( const std::string& input, shared_ptr<MathObj> obj ) 
+{
+    IdCollection ids;
+    LoadIdTable( &ids );
+    ConvertFromOMString( &ids, input, obj );
+}
+void ConvertFromOMString( IdCollection* ids, const std::string& input, shared_ptr<MathObj> obj ) 
+{
+	TiXmlDocument doc;
+	doc.Parse( input.c_str() );
+	if( doc.Error() )
+	{
+		throw std::invalid_argument( doc.ErrorDesc() );
+	}
+
+	TiXmlHandle hDoc( &doc );
+	TiXmlElement* pElem;
+
+	pElem = hDoc.FirstChildElement().Element();
+	if( pElem == 0 )
+	{
+		throw std::invalid_argument( "Empty OpenMath document" );
+	}
+
+	ConvertElemToObj( ids, pElem, obj );
+}
+// Значение обязательного атрибута элемента, если его нет - бросает std::invalid_argument
+static const char* getRequiredAttribute( TiXmlElement* pElem, const char* name )
+{
+	const char* value = pElem->Attribute( name );
+	if( value == 0 )
+	{
+		throw std::invalid_argument( std::string( "Missing attribute " ) + name + " in " + pElem->Value() );
+	}
+	return value;
+}
 void ConvertElemToObj( IdCollection* ids, TiXmlElement* pElem, shared_ptr<MathObj> obj ) {
 	for( pElem; pElem; pElem = pElem->NextSiblingElement() ) //пробегаемся по всем элементам одного слоя
 	{
@@ -84,23 +122,25 @@ void ConvertElemToObj( IdCollection* ids, TiXmlElement* pElem, shared_ptr<MathOb
 		//Если переменная
 		else if( pKey == "OMV" ) 
 		{
-			TiXmlAttribute* pAttrib = pElem->FirstAttribute();
-			shared_ptr<ParamObj> node ( new ParamObj( pAttrib->Value() ) );
+			shared_ptr<ParamObj> node ( new ParamObj( getRequiredAttribute( pElem, "name" ) ) );
             static_cast<FormulaObj*>( obj.get() )->params.push_back( node );
 		}
 
 		//Если целое число
 		else if( pKey == "OMI" ) 
 		{
-			shared_ptr<ParamObj> node ( new ParamObj( pElem->GetText() ) );
+			if( pText == 0 )
+			{
+				throw std::invalid_argument( "Empty OMI" );
+			}
+			shared_ptr<ParamObj> node ( new ParamObj( pText ) );
 			static_cast<FormulaObj*>(obj.get())->params.push_back( node );
 		}
 
         //Если десятичное число
         else if( pKey == "OMF" )
         {
-            TiXmlAttribute* pAttrib = pElem->FirstAttribute();
-            shared_ptr<ParamObj> node ( new ParamObj( pAttrib->Value( ) ) );
+            shared_ptr<ParamObj> node ( new ParamObj( getRequiredAttribute( pElem, "dec" ) ) );
 			static_cast<FormulaObj*>(obj.get())->params.push_back( node );
 
         }
@@ -115,26 +155,8 @@ void ConvertElemToObj( IdCollection* ids, TiXmlElement* pElem, shared_ptr<MathOb
 		//Если операнд
 		else if( pKey == "OMS" ) 
 		{
-			TiXmlAttribute* pAttrib = pElem->FirstAttribute();
-			std::string name = pAttrib->Name(); // Тип атрибута
-
-            //Находим атрибут, отвечающий за название словаря, содержащего наш атрибут
-            while( name != "cd" )
-            {
-                pAttrib = pAttrib->Next( );
-                name = pAttrib->Name( );
-            }
-
-            std::string cd = pAttrib->Value(); // получаем требуемый словарь
-
-			//Находим атрибут, отвечающий за тип операнда
-			while( name != "name" ) 
-			{
-				pAttrib = pAttrib->Next();
-				name = pAttrib->Name();
-			}
-
-			std::string operand = pAttrib->Value(); // Получаем тип операнда
+            std::string cd = getRequiredAttribute( pElem, "cd" ); // получаем требуемый словарь
+			std::string operand = getRequiredAttribute( pElem, "name" ); // Получаем тип операнда
             SetFormulaObjType( ids, static_pointer_cast<FormulaObj>( obj ), &cd, &operand );
 		}
 	}
@@ -142,75 +164,82 @@ void ConvertElemToObj( IdCollection* ids, TiXmlElement* pElem, shared_ptr<MathOb
 }
 void ConvertToOM( std::string outputFileName, shared_ptr<MathObj> obj ) 
 {
-	TiXmlDocument doc;
-	TiXmlElement* element (new TiXmlElement( "OMOBJ" ));
-	element->SetAttribute( "xmlns", "http://www.openmath.org/OpenMath" );
-	doc.LinkEndChild( element );
-
+    CMathTree tree;
+    tree.Assign( obj );
+    ConvertToOM( outputFileName, tree );
+}
+void ConvertToOM( std::string outputFileName, const CMathTree& tree ) 
+{
     AttrCollection attrs;
     LoadAttrTable( &attrs );
-    ConvertObjToElem( &attrs, element, static_pointer_cast<FormulaObj>( obj )->params[0] );
 
-    doc.SaveFile( outputFileName.data() );
+    std::string output;
+    ConvertToOMString( &attrs, tree, output, false );
+    std::ofstream ofs( outputFileName, std::ios::out );
+    ofs << output;
 }
-void ConvertObjToElem( AttrCollection* attrs, TiXmlElement* pElem, shared_ptr<MathObj> obj ) 
+void ConvertToOMString( const CMathTree& tree, std::string& output ) 
 {
-	std::string objType = typeid( *obj ).name();
-	// std::cout << objType.c_str() << std::endl;
-	if( objType == "class FormulaObj" ) 
-    {
-		TiXmlElement* element ( new TiXmlElement( "OMA" ) );
-		pElem->LinkEndChild( element );
-
-		TiXmlElement* formulaElement ( new TiXmlElement( "OMS" ) );
-		 
-		SetFormulaElementAttribute( attrs, formulaElement, ((FormulaObj*)obj.get())->GetType() );
-		element->LinkEndChild(formulaElement);
-
-		std::vector<shared_ptr<MathObj>>::iterator it = (dynamic_pointer_cast<FormulaObj>(obj)->params.begin());
-		std::vector<shared_ptr<MathObj>>::const_iterator itEnd = (dynamic_pointer_cast<FormulaObj>(obj))->params.end();
-		for( it; it != itEnd; ++it ) 
-		{
-			ConvertObjToElem( attrs, element, *it );
-		}
-    }
-    else if( objType == "class ParamObj" )
+    AttrCollection attrs;
+    LoadAttrTable( &attrs );
+    ConvertToOMString( &attrs, tree, output, false );
+}
+void ConvertToOMString( AttrCollection* attrs, const CMathTree& tree, std::string& output, bool singleLine ) 
+{
+    output.clear();
+    CXmlTextWriter xml( output, singleLine );
+    xml.OpenElement( "OMOBJ" );
+    xml.AddAttribute( "xmlns", "http://www.openmath.org/OpenMath" );
+    COMWriter writer( attrs, xml );
+    tree.Walk( writer );
+    xml.CloseElement();
+}
+void COMWriter::VisitParam( const CMathTree& tree, int node ) 
+{
+    const char* val = tree.GetValue( node );
+    if( val[0] > 47 && val[0] < 58 ) // Если это число
     {
-		std::string val = (static_pointer_cast< ParamObj >(obj))->GetVal();
-        if( val[0] > 47 && val[0] < 58 ) // Если это число
+        if( strchr( val, '.' ) != 0 ) // И в нем есть точка
         {
-            if( val.find( '.' ) != std::string::npos ) // И в нем есть точка
-            {
-                TiXmlElement* element (new TiXmlElement( "OMF" ));
-                element->SetAttribute( "dec", val.c_str() );
-                pElem->LinkEndChild( element );
-            }
-            else
-            {
-                TiXmlElement* element = (new TiXmlElement( "OMI" ));
-                TiXmlText* text = ( new TiXmlText( val.c_str() ) );
-                element->LinkEndChild( text );
-                pElem->LinkEndChild( element );
-            }
+            xml.OpenElement( "OMF" );
+            xml.AddAttribute( "dec", val );
+            xml.CloseElement();
         }
         else
         {
-            TiXmlElement* element = ( new TiXmlElement( "OMV" ) );
-            element->SetAttribute( "name", val.c_str( ) );
-            pElem->LinkEndChild( element );
+            xml.WriteTextElement( "OMI", val );
         }
     }
+    else
+    {
+        xml.OpenElement( "OMV" );
+        xml.AddAttribute( "name", val );
+        xml.CloseElement();
+    }
+}
+bool COMWriter::EnterFormula( const CMathTree& tree, int node ) 
+{
+	// Все потомки пишутся внутрь OMA, после OMS с самой операцией
+	xml.OpenElement( "OMA" );
+	xml.OpenElement( "OMS" );
+	SetFormulaElementAttribute( attrs, xml, tree.GetType( node ) );
+	xml.CloseElement();
+	return true;
 }
-void SetFormulaElementAttribute( AttrCollection* attrs, TiXmlElement* pElem, TNodeType type ) 
+void COMWriter::LeaveFormula( const CMathTree& tree, int node ) 
+{
+	xml.CloseElement();
+}
+void SetFormulaElementAttribute( AttrCollection* attrs, CXmlTextWriter& xml, TNodeType type ) 
 {
     if( attrs->find( static_cast<int>( type ) ) != attrs->end() )
     {
-        pElem->SetAttribute( "cd", (*attrs)[type].first.c_str() );
-        pElem->SetAttribute( "name", (*attrs)[type].second.c_str() );
+        xml.AddAttribute( "cd", (*attrs)[type].first.c_str() );
+        xml.AddAttribute( "name", (*attrs)[type].second.c_str() );
     }
     else
     {
-		std::cerr << "Error: invalid type of Node in MathObj:" << type << std::endl;
+		throw std::invalid_argument( "Operation is not supported in OpenMath" );
 	}
 }
 void SetFormulaObjType( IdCollection* ids, shared_ptr<FormulaObj> obj, std::string* cd, std::string* operand)
@@ -227,7 +256,12 @@ void SetFormulaObjType( IdCollection* ids, shared_ptr<FormulaObj> obj, std::stri
         }
     }
 
-    obj->SetType( TNodeType( (*ids)[*operand].second ) );
+    IdCollection::const_iterator id = ids->find( *operand );
+    if( id == ids->end() )
+    {
+        throw std::invalid_argument( "Unknown OpenMath symbol " + *cd + ":" + *operand );
+    }
+    obj->SetType( TNodeType( id->second.second ) );
     //std::cout << *operand << " " << (*ids)[*operand].second << std::endl;
 }
 
@@ -2,16 +2,36 @@
 // Назначение: Объявление функций, использующихся для конвертации между форматами OpenMath и MathObj
 
 #include "MathFormObj.h"
+#include "MathTree.h"
+#include "XmlTextWriter.h"
 #include <map>
+#include <vector>
 
 typedef std::map<std::string, std::pair<std::string, int>> IdCollection;
 typedef std::map<int, std::pair<std::string, std::string>> AttrCollection;
 
 void ConvertFromOM( std::string, shared_ptr<MathObj> ); // Конвертирует OpenMath в MathObj, принимая на вход имя файла, откуда читаем
+void ConvertFromOMString( const std::string&, shared_ptr<MathObj> ); // Конвертирует OpenMath в MathObj, принимая на вход сам текст OpenMath; при ошибке бросает std::invalid_argument
+void ConvertFromOMString( IdCollection*, const std::string&, shared_ptr<MathObj> ); // То же, но с уже загруженной таблицей операторов
 void ConvertElemToObj( IdCollection*, TiXmlElement*, shared_ptr<MathObj> ); // Конвертирует в MathObj, принимая на вход указатель на текущий элемент DOM
 void ConvertToOM( std::string, shared_ptr<MathObj> ); // Конвертирует MathObj в OpenMath, принимая на вход имя файла, в который записываем
-void ConvertObjToElem( AttrCollection*, TiXmlElement*, shared_ptr<MathObj> ); // Конвертирует в DOM, принимая на вход указатель на текущий элемент MathObj
-void SetFormulaElementAttribute( AttrCollection*, TiXmlElement*, const TNodeType ); // Устанавливает элементу DOM нужные атрибуты
-void SetFormulaObjType( IdCollection*, shared_ptr<FormulaObj>, std::string*, std::string* ); // Устанавливает элементу FormulaObj нужный флаг в зависимости от атрибутов 
+void ConvertToOM( std::string, const CMathTree& ); // Конвертирует компактное дерево формулы в OpenMath
+void ConvertToOMString( const CMathTree&, std::string& ); // Конвертирует компактное дерево формулы в строку OpenMath
+void ConvertToOMString( AttrCollection*, const CMathTree&, std::string&, bool singleLine ); // То же с уже загруженной таблицей атрибутов, singleLine - без переносов строк
+void SetFormulaElementAttribute( AttrCollection*, CXmlTextWriter&, const TNodeType ); // Записывает открытому элементу OMS нужные атрибуты, для неизвестной операции бросает std::invalid_argument
+void SetFormulaObjType( IdCollection*, shared_ptr<FormulaObj>, std::string*, std::string* ); // Устанавливает элементу FormulaObj нужный флаг в зависимости от атрибутов, для неизвестного символа бросает std::invalid_argument
 void LoadIdTable( IdCollection* ); // Подгружает таблицу операторов
-void LoadAttrTable( AttrCollection* ); // Подгружает таблицу атрибутов
\ No newline at end of file
+void LoadAttrTable( AttrCollection* ); // Подгружает таблицу атрибутов
+
+// Обход дерева, записывающий его в текст OpenMath: каждая операция становится элементом OMA внутри текущего открытого элемента
+class COMWriter : public CMathTreeVisitor
+{
+    AttrCollection* attrs;
+    CXmlTextWriter& xml;
+public:
+    COMWriter( AttrCollection* _attrs, CXmlTextWriter& _xml ) : attrs( _attrs ), xml( _xml ) {}
+
+    virtual void VisitParam( const CMathTree& tree, int node );
+    virtual bool EnterFormula( const CMathTree& tree, int node );
+    virtual void LeaveFormula( const CMathTree& tree, int node );
+};
\ No newline at end of file
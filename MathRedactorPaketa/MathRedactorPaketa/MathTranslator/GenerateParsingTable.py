@@ -0,0 +1,351 @@
+# -*- coding: utf-8 -*-
+# Описание: Генератор таблицы LR-парсера для Latex. Читает грамматику из parser.y, строит LALR(1)-автомат
+# (конфликты разрешаются по приоритетам %left/%right/%nonassoc так же, как в Bison) и записывает
+# плоскую таблицу переходов в ParsingTable.h и ParsingTable.cpp. Номера столбцов берутся из enum TTokenType
+# в LatexTokens.h, номера правил - порядок правил в parser.y (CLatexParser::applyRule).
+#
+# Запуск: python GenerateParsingTable.py [каталог проекта [файл-метка]]. Вызывается при сборке проекта, если изменился
+# parser.y, LatexTokens.h или сам генератор. Неизменившиеся ParsingTable.* не перезаписываются, поэтому для MSBuild
+# результатом шага служит файл-метка, который обновляется при каждом запуске
+# Без Python шаг сборки только предупреждает и оставляет сохраненные в репозитории ParsingTable.* как есть
+
+from __future__ import print_function, unicode_literals
+import io
+import os
+import re
+import sys
+
+# Соответствие терминалов грамматики и значений TTokenType
+TERMINALS = {
+	"'*'": 'TT_MULTIPLY',
+	"'+'": 'TT_PLUS',
+	"'-'": 'TT_MINUS',
+	"'['": 'TT_LBRACKET',
+	"']'": 'TT_RBRACKET',
+	"'^'": 'TT_POW',
+	"'_'": 'TT_UNDERSCORE',
+	"'{'": 'TT_LCURLYBRACE',
+	"'}'": 'TT_RCURLYBRACE',
+	'PROD': 'TT_PROD',
+	'SUM': 'TT_SUM',
+	'COT': 'TT_COT',
+	'TAN': 'TT_TAN',
+	'COS': 'TT_COS',
+	'SIN': 'TT_SIN',
+	'ID': 'TT_ID',
+	'FRAC': 'TT_FRAC',
+	'SQRT': 'TT_SQRT',
+	'"("': 'TT_LBRACE',
+	'")"': 'TT_RBRACE',
+	'$end': 'TT_EOF',
+}
+NONTERMINAL_COLUMN = 'TT_NONTERMINAL'
+END = '$end'
+START = '$accept'
+
+
+class GrammarError(Exception):
+	pass
+
+
+def read_token_columns(path):
+	columns = {}
+	with io.open(path, encoding='utf-8-sig') as f:
+		for name, value in re.findall(r'\b(TT_\w+)\s*=\s*(\d+)', f.read()):
+			columns[name] = int(value)
+	return columns
+
+
+def tokenize(text):
+	return re.findall(r"'[^']'|\"[^\"]+\"|%?\w+|[:|;]", text)
+
+
+def read_grammar(path):
+	with io.open(path, encoding='utf-8') as f:
+		text = f.read()
+	text = re.sub(r'%\{.*?%\}', '', text, flags=re.S)
+	declarations, rules_text = text.split('%%')[:2]
+
+	# Приоритеты: чем позже объявлен %left/%right, тем выше приоритет
+	precedence = {}
+	level = 0
+	for line in declarations.splitlines():
+		words = tokenize(line)
+		if words and words[0] in ('%left', '%right', '%nonassoc'):
+			level += 1
+			for symbol in words[1:]:
+				precedence[symbol] = (level, words[0][1:])
+
+	rules = []
+	words = tokenize(rules_text)
+	position = 0
+	while position < len(words):
+		left = words[position]
+		if words[position + 1] != ':':
+			raise GrammarError('expected ":" after ' + left)
+		position += 2
+		right = []
+		rule_precedence = None
+		while True:
+			word = words[position]
+			position += 1
+			if word in ('|', ';'):
+				rules.append((left, tuple(right), rule_precedence))
+				right = []
+				rule_precedence = None
+				if word == ';':
+					break
+			elif word == '%prec':
+				rule_precedence = words[position]
+				position += 1
+			else:
+				right.append(word)
+	return rules, precedence
+
+
+class Automaton(object):
+	def __init__(self, rules, precedence):
+		self.nonterminals = sorted(set(left for left, _, _ in rules))
+		start = rules[0][0]
+		# Правило 0 - $accept: Exp $end, как в Bison. Переход по $end ведет в состояние принятия
+		self.rules = [(START, (start, END), None)] + rules
+		self.precedence = precedence
+		self.conflicts = []
+
+		self.first = dict((n, set()) for n in self.nonterminals)
+		self.nullable = set()
+		changed = True
+		while changed:
+			changed = False
+			for left, right, _ in self.rules[1:]:
+				first = self.first_of_sequence(right)
+				if not first <= self.first[left]:
+					self.first[left] |= first
+					changed = True
+				if left not in self.nullable and all(s in self.nullable for s in right):
+					self.nullable.add(left)
+					changed = True
+
+	def is_terminal(self, symbol):
+		return symbol not in self.nonterminals and symbol != START
+
+	def first_of_sequence(self, symbols):
+		result = set()
+		for symbol in symbols:
+			if self.is_terminal(symbol):
+				result.add(symbol)
+				return result
+			result |= self.first[symbol]
+			if symbol not in self.nullable:
+				return result
+		return result
+
+	def closure(self, items):
+		# items - множество (правило, позиция, предпросмотр)
+		result = set(items)
+		queue = list(items)
+		while queue:
+			rule, dot, lookahead = queue.pop()
+			right = self.rules[rule][1]
+			if dot == len(right) or self.is_terminal(right[dot]):
+				continue
+			follow = self.first_of_sequence(right[dot + 1:])
+			if all(s in self.nullable for s in right[dot + 1:]):
+				follow = follow | set([lookahead])
+			for index, (left, _, _) in enumerate(self.rules):
+				if left != right[dot]:
+					continue
+				for symbol in follow:
+					item = (index, 0, symbol)
+					if item not in result:
+						result.add(item)
+						queue.append(item)
+		return frozenset(result)
+
+	def build(self, symbol_order):
+		# Канонические LR(1)-состояния склеиваются по ядрам (LALR). Номера состояниям даются
+		# в порядке обхода в ширину, переходы перебираются в порядке столбцов таблицы
+		start = self.closure([(0, 0, None)])
+		core = lambda state: frozenset((rule, dot) for rule, dot, _ in state)
+		kernel = lambda state: sorted(set((rule, dot) for rule, dot, _ in state if dot > 0 or rule == 0))
+
+		cores = [core(start)]
+		lookaheads = [dict()]
+		transitions = [dict()]
+		queue = [start]
+		seen = set([start])
+		while queue:
+			state = queue.pop(0)
+			number = cores.index(core(state))
+			for rule, dot, lookahead in state:
+				lookaheads[number].setdefault((rule, dot), set()).add(lookahead)
+			for symbol in symbol_order:
+				moved = [(rule, dot + 1, lookahead) for rule, dot, lookahead in state
+					if dot < len(self.rules[rule][1]) and self.rules[rule][1][dot] == symbol]
+				if not moved:
+					continue
+				target = self.closure(moved)
+				if core(target) not in cores:
+					cores.append(core(target))
+					lookaheads.append(dict())
+					transitions.append(dict())
+				transitions[number][symbol] = cores.index(core(target))
+				if target not in seen:
+					seen.add(target)
+					queue.append(target)
+
+		self.states = []
+		for number, state_core in enumerate(cores):
+			self.states.append({
+				'kernel': kernel([(rule, dot, None) for rule, dot in state_core]),
+				'items': lookaheads[number],
+				'transitions': transitions[number],
+			})
+
+	def rule_precedence(self, rule):
+		_, right, explicit = self.rules[rule]
+		if explicit is not None:
+			return self.precedence.get(explicit)
+		terminals = [s for s in right if self.is_terminal(s)]
+		return self.precedence.get(terminals[-1]) if terminals else None
+
+	def actions(self, number):
+		# Возвращает словарь символ -> ('shift', состояние) | ('reduce', правило) | ('error', None)
+		state = self.states[number]
+		actions = dict((symbol, ('shift', target)) for symbol, target in state['transitions'].items())
+		for (rule, dot), lookahead_set in sorted(state['items'].items()):
+			if rule == 0 or dot != len(self.rules[rule][1]):
+				continue
+			for symbol in sorted(lookahead_set):
+				current = actions.get(symbol)
+				if current is None:
+					actions[symbol] = ('reduce', rule)
+				elif current[0] == 'reduce':
+					self.conflicts.append('state %d: reduce/reduce on %s, rules %d and %d' % (number, symbol, current[1], rule))
+					actions[symbol] = ('reduce', min(current[1], rule))
+				elif current[0] == 'shift':
+					actions[symbol] = self.resolve(number, symbol, current, rule)
+		return actions
+
+	def resolve(self, number, symbol, shift, rule):
+		rule_level = self.rule_precedence(rule)
+		symbol_level = self.precedence.get(symbol)
+		if rule_level is None or symbol_level is None:
+			self.conflicts.append('state %d: shift/reduce on %s, rule %d' % (number, symbol, rule))
+			return shift
+		if symbol_level[0] > rule_level[0]:
+			return shift
+		if symbol_level[0] < rule_level[0]:
+			return ('reduce', rule)
+		if symbol_level[1] == 'left':
+			return ('reduce', rule)
+		if symbol_level[1] == 'right':
+			return shift
+		return ('error', None)
+
+	def format_item(self, rule, dot):
+		left, right, _ = self.rules[rule]
+		return '%s: %s' % (left, ' '.join(right[:dot] + ('.',) + right[dot:]))
+
+
+def generate(project_dir):
+	columns = read_token_columns(os.path.join(project_dir, 'LatexTokens.h'))
+	rules, precedence = read_grammar(os.path.join(project_dir, 'parser.y'))
+
+	automaton = Automaton(rules, precedence)
+	if len(automaton.nonterminals) != 1:
+		raise GrammarError('CLatexParser supports exactly one nonterminal')
+	width = columns['TT_EOF'] + 1
+	column_of = {automaton.nonterminals[0]: columns[NONTERMINAL_COLUMN]}
+	for symbol, token in TERMINALS.items():
+		column_of[symbol] = columns[token]
+	for _, right, _ in automaton.rules:
+		for symbol in right:
+			if symbol not in column_of:
+				raise GrammarError('no TTokenType for symbol ' + symbol)
+
+	automaton.build(sorted(column_of, key=lambda symbol: column_of[symbol]))
+
+	rows = []
+	for number in range(len(automaton.states)):
+		row = [0] * width
+		for symbol, (kind, value) in automaton.actions(number).items():
+			if kind == 'shift':
+				row[column_of[symbol]] = value
+			elif kind == 'reduce':
+				row[column_of[symbol]] = -value
+		rows.append(row)
+
+	if len(automaton.states) > 127 or len(automaton.rules) > 128:
+		raise GrammarError('table does not fit into signed char')
+	for conflict in automaton.conflicts:
+		print('parser.y: warning: ' + conflict, file=sys.stderr)
+
+	banner = ('// Файл сгенерирован скриптом GenerateParsingTable.py по грамматике parser.y. Не редактируйте его вручную:\n'
+		'// измените parser.y и пересоберите проект (или запустите скрипт)\n')
+
+	header = [banner,
+		'#pragma once\n',
+		'// Таблица переходов LR-парсера: ParsingTable[состояние * ParsingTableWidth + токен].',
+		'// Положительное число - сдвиг (shift) и переход в состояние с этим номером, отрицательное - свертка (reduce)',
+		'// по правилу с этим номером, ParsingError - синтаксическая ошибка. Столбцы соответствуют TTokenType,',
+		'// нетерминал - столбец TT_NONTERMINAL\n',
+		'const int ParsingTableWidth = %d;' % width,
+		'const int ParsingTableHeight = %d;' % len(rows),
+		'const int ParsingError = 0;\n',
+		'extern const signed char ParsingTable[ParsingTableHeight * ParsingTableWidth];\n',
+		'// Длины правых частей правил. Правило 0 - $accept: Exp $end',
+		'const int ParsingRulesCount = %d;\n' % (len(automaton.rules) - 1),
+		'extern const unsigned char ParsingRuleLength[ParsingRulesCount + 1];\n']
+
+	titles = [''] * width
+	for symbol, column in column_of.items():
+		titles[column] = 'EOF' if symbol == END else symbol.strip('\'"')
+	source = [banner,
+		'#include "ParsingTable.h"',
+		'#include "LatexTokens.h"\n',
+		'static_assert( ParsingTableWidth == TT_EOF + 1, "ParsingTable.cpp is out of date, run GenerateParsingTable.py" );\n',
+		'const signed char ParsingTable[ParsingTableHeight * ParsingTableWidth] = {',
+		'\t/*' + ','.join('%4s' % title for title in titles) + ' */']
+	for number, row in enumerate(rows):
+		source.append('\t// %d' % number)
+		for rule, dot in automaton.states[number]['kernel']:
+			source.append('\t//   ' + automaton.format_item(rule, dot))
+		last = number == len(rows) - 1
+		source.append('\t  ' + ','.join('%4d' % value for value in row) + ('' if last else ','))
+	source.append('};\n')
+	source.append('const unsigned char ParsingRuleLength[ParsingRulesCount + 1] = {')
+	for number, (left, right, _) in enumerate(automaton.rules):
+		last = number == len(automaton.rules) - 1
+		source.append('\t%d%s // %d %s' % (len(right), '' if last else ',', number, automaton.format_item(number, len(right))[:-2]))
+	source.append('};\n')
+
+	write(os.path.join(project_dir, 'ParsingTable.h'), '\n'.join(header))
+	write(os.path.join(project_dir, 'ParsingTable.cpp'), '\n'.join(source))
+	print('ParsingTable: %d states, %d rules, %d conflicts' % (len(rows), len(automaton.rules) - 1, len(automaton.conflicts)))
+
+
+def write(path, text):
+	# Файлы проекта в UTF-8 с BOM; файл перезаписывается только при изменении, чтобы не пересобирать проект зря
+	data = ('\ufeff' + text).encode('utf-8')
+	if os.path.exists(path):
+		with open(path, 'rb') as f:
+			if f.read() == data:
+				return
+	with open(path, 'wb') as f:
+		f.write(data)
+
+
+def touch(path):
+	with open(path, 'a'):
+		os.utime(path, None)
+
+
+if __name__ == '__main__':
+	try:
+		generate(sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__)))
+	except GrammarError as error:
+		print('parser.y: error: ' + str(error), file=sys.stderr)
+		sys.exit(1)
+	if len(sys.argv) > 2:
+		touch(sys.argv[2])
@@ -1,83 +1,104 @@
 ﻿// Автор: Азат Давлетшин
-// Описание: Реализация состояний лексера для Latex
+// Описание: Реализация лексера для Latex
 
 #include "LatexLexerStates.h"
-#include <algorithm>
-#include <assert.h>
+#include <stdexcept>
 
 using namespace std;
 
-static const CTokenFinder TokenFinder;
+namespace {
 
-shared_ptr<CLatexState> CLatexState::TryStopSymbol( char symbol )
-{
-	switch( symbol ) 
+// Классы символов. Стоп-символы завершают идентификатор или имя функции
+enum TSymbolClass {
+	SC_ID, // часть идентификатора
+	SC_SPACE,
+	SC_FUNCTION, // обратный слеш, начало функции
+	SC_SINGLE // односимвольная лексема
+};
+
+// Таблица переходов автомата: класс символа и лексема для односимвольных стоп-символов
+struct CSymbolTable {
+	unsigned char Classes[256];
+	unsigned char Tokens[256];
+
+	CSymbolTable()
 	{
-		case '\\':
-			return shared_ptr<CLatexFuncState>(new CLatexFuncState());
-		case '(':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_LBRACE));
-		case ')':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState( TT_RBRACE ));
-		case '{':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_LCURLYBRACE));
-		case '}':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_RCURLYBRACE));
-		case '[':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_LBRACKET));
-		case ']':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_RBRACKET));
-		case '+':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_PLUS));
-		case '-':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_MINUS));
-		case '*':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_MULTIPLY));
-		case '^':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_POW));
-		case ' ':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_SPACE));
-		case '_':
-			return shared_ptr<CLatexSingleState>(new CLatexSingleState(TT_UNDERSCORE));
-		default:
-			return 0;
+		for( int i = 0; i < 256; ++i ) {
+			Classes[i] = SC_ID;
+			Tokens[i] = TT_ID;
+		}
+		Classes[static_cast<unsigned char>( ' ' )] = SC_SPACE;
+		Classes[static_cast<unsigned char>( '\\' )] = SC_FUNCTION;
+		setSingle( '(', TT_LBRACE );
+		setSingle( ')', TT_RBRACE );
+		setSingle( '{', TT_LCURLYBRACE );
+		setSingle( '}', TT_RCURLYBRACE );
+		setSingle( '[', TT_LBRACKET );
+		setSingle( ']', TT_RBRACKET );
+		setSingle( '+', TT_PLUS );
+		setSingle( '-', TT_MINUS );
+		setSingle( '*', TT_MULTIPLY );
+		setSingle( '^', TT_POW );
+		setSingle( '_', TT_UNDERSCORE );
 	}
-}
 
-shared_ptr<CLatexState> CLatexIDState::Accept( char symbol )
-{
-	shared_ptr<CLatexState> tryStopSymbol = TryStopSymbol( symbol );
-	if( tryStopSymbol != 0 ) {
-		isDetached = true;
-		return tryStopSymbol;
+private:
+	void setSingle( char symbol, TTokenType type )
+	{
+		Classes[static_cast<unsigned char>( symbol )] = SC_SINGLE;
+		Tokens[static_cast<unsigned char>( symbol )] = static_cast<unsigned char>( type );
 	}
+};
 
-	id += symbol; 
-	return shared_from_this();
-}
-
-shared_ptr<CLatexState> CLatexFuncState::Accept( char symbol )
-{
-	shared_ptr<CLatexState> tryStopSymbol = TryStopSymbol( symbol );
-	if( tryStopSymbol != 0 ) {
-		isDetached = true;
-		return tryStopSymbol;
-	}
+const CSymbolTable SymbolTable;
 
-	eatenStr += symbol;
-	type = TokenFinder.FindFunction( eatenStr );
+} // namespace
 
-	return shared_from_this();
+void CLatexLexer::Init( const char* _text, int _length )
+{
+	text = _text;
+	length = _length;
+	position = 0;
 }
 
-shared_ptr<CLatexState> CLatexSingleState::Accept( char symbol )
+CLatexToken CLatexLexer::Next()
 {
-	isDetached = true;
+	while( position < length && SymbolTable.Classes[static_cast<unsigned char>( text[position] )] == SC_SPACE ) {
+		++position;
+	}
 
-	shared_ptr<CLatexState> tryStopSymbol = TryStopSymbol( symbol );
-	if( tryStopSymbol != 0 ) {
-		return tryStopSymbol;
+	CLatexToken token;
+	token.Offset = position;
+	if( position == length ) {
+		token.Type = TT_EOF;
+		token.Length = 0;
+		return token;
 	}
 
-	return shared_ptr<CLatexIDState>(new CLatexIDState( symbol ));
-}
\ No newline at end of file
+	unsigned char symbol = static_cast<unsigned char>( text[position] );
+	switch( SymbolTable.Classes[symbol] ) {
+		case SC_SINGLE:
+			token.Type = static_cast<TTokenType>( SymbolTable.Tokens[symbol] );
+			++position;
+			break;
+		case SC_FUNCTION:
+			// Имя функции - все символы до следующего стоп-символа
+			++position;
+			while( position < length && SymbolTable.Classes[static_cast<unsigned char>( text[position] )] == SC_ID ) {
+				++position;
+			}
+			token.Type = CTokenFinder::FindFunction( text + token.Offset + 1, position - token.Offset - 1 );
+			if( token.Type == TT_NOTFOUND ) {
+				throw invalid_argument( "Lexical error" );
+			}
+			break;
+		default:
+			while( position < length && SymbolTable.Classes[static_cast<unsigned char>( text[position] )] == SC_ID ) {
+				++position;
+			}
+			token.Type = TT_ID;
+			break;
+	}
+	token.Length = position - token.Offset;
+	return token;
+}
@@ -4,48 +4,38 @@
 #pragma once
 
 #include "LatexLexerStates.h"
-#include "MathFormObj.h"
-#include <stack>
-
-// Если в результате свертки получили нетерминал, то нужно его протолкнуть как обычный токен,
-// поэтому требуется еще одно состояние лексера
-class CLatexExpState : public CLatexState {
-public:
-	CLatexExpState( shared_ptr<MathObj> _node ) { type = TT_NONTERMINAL; node = _node; isDetached = true; }
-
-	shared_ptr<MathObj> GetNode() { return node; }
-
-	// Этот метод не вызвается
-	virtual shared_ptr<CLatexState> Accept( char symbol ) { assert( false ); return shared_ptr<CLatexState>(0); }
-
-private:
-	shared_ptr<MathObj> node;
-};
+#include "MathTree.h"
+#include <vector>
 
 // LR-парсер для Latex. Для работы необходимо проинициализировать методом Init(). Когда строка прочитана, необходимо
-// протолкнуть EOF с помощью метода End(), который возращает результат парсинга в виде корня синтаксического дерева
+// протолкнуть EOF с помощью метода End(), после которого в дереве записан корень формулы
 class CLatexParser {
 public:
-	void TryParse( shared_ptr<CLatexState> state );
-	void Parse( shared_ptr<CLatexState> state );
-	// Протолкнуть токен EOF и получить корень синтаксического дерева
-	shared_ptr<MathObj> End();
+	CLatexParser() : text( 0 ), tree( 0 ) {}
 
-	// Инициализация парсера
-	void Init();
+	void Parse( const CLatexToken& token );
+	// Протолкнуть токен EOF и записать корень в дерево
+	void End();
+
+	// Инициализация парсера. text - строка, на которую ссылаются лексемы, tree - дерево, в которое
+	// добавляются узлы формулы
+	void Init( const char* text, CMathTree* tree );
 
 private:
-	// Состояние LR-паресера. Хранит в себе терминал или нетерминал, а также свой номер
-	// в таблице переходов
-	struct CParserState {
-		int Id;
-		TTokenType Token;
-		shared_ptr<MathObj> Node;
-		std::string Val; // Для токена TT_ID
+	// Элемент стека значений: терминал (лексема) или нетерминал (индекс узла в дереве)
+	struct CParserValue {
+		CLatexToken Token; // Для TT_ID по смещению и длине берется имя из text
+		int Node;
 	};
 
-	shared_ptr<CLatexExpState> applyRule( int rule );
-	void popTerminal( TTokenType type );
-	void popNonTerminal( shared_ptr<MathObj> node, bool pushBack = true );
-	std::stack<CParserState> states;
+	// Построить узел по правилу. rhs - значения правой части правила
+	int applyRule( int rule, const CParserValue* rhs );
+	void push( int state, const CLatexToken& token, int node );
+
+	// Стек состояний LR-парсера (номера в таблице переходов) и параллельный ему стек значений.
+	// Память под стеки переиспользуется между вызовами Init()
+	std::vector<int> states;
+	std::vector<CParserValue> values;
+	const char* text;
+	CMathTree* tree;
 };
\ No newline at end of file
@@ -2,28 +2,44 @@
 // Описание: Реализация класса, который провереят существовании функции и возращает токен
 
 #include "LatexTokens.h"
+#include <string.h>
 
-using namespace std;
+// Позиции в таблице заданы hash(): ( первый символ + последний символ + длина ) & 15 дает
+// разные значения для всех функций. При добавлении функции нужно проверить, что коллизий нет
+const CTokenFinder::CFunction CTokenFinder::table[CTokenFinder::tableSize] = {
+	{ 0, 0, TT_NOTFOUND },
+	{ 0, 0, TT_NOTFOUND },
+	{ 0, 0, TT_NOTFOUND },
+	{ "sum", 3, TT_SUM },
+	{ "sin", 3, TT_SIN },
+	{ "tan", 3, TT_TAN },
+	{ 0, 0, TT_NOTFOUND },
+	{ 0, 0, TT_NOTFOUND },
+	{ "prod", 4, TT_PROD },
+	{ "cos", 3, TT_COS },
+	{ "cot", 3, TT_COT },
+	{ "sqrt", 4, TT_SQRT },
+	{ 0, 0, TT_NOTFOUND },
+	{ "frac", 4, TT_FRAC },
+	{ 0, 0, TT_NOTFOUND },
+	{ 0, 0, TT_NOTFOUND }
+};
 
-CTokenFinder::CTokenFinder()
+int CTokenFinder::hash( const char* name, int length )
 {
-	functions["cos"] = TT_COS;
-	functions["cot"] = TT_COT;
-	functions["frac"] = TT_FRAC;
-	functions["prod"] = TT_PROD;
-	functions["sin"] = TT_SIN;
-	functions["sum"] = TT_SUM;
-	functions["tan"] = TT_TAN;
-	functions["sqrt"] = TT_SQRT;
+	return ( static_cast<unsigned char>( name[0] ) + static_cast<unsigned char>( name[length - 1] ) + length ) & ( tableSize - 1 );
 }
 
-TTokenType CTokenFinder::FindFunction( const string& str ) const
+TTokenType CTokenFinder::FindFunction( const char* name, int length )
 {
-	unordered_map<string, TTokenType>::const_iterator it = functions.find( str );
-	
-	if( it == functions.end() ) {
+	if( length == 0 ) {
 		return TT_NOTFOUND;
 	}
 
-	return it->second;
-}
\ No newline at end of file
+	const CFunction& function = table[hash( name, length )];
+	if( function.Length != length || memcmp( function.Name, name, length ) != 0 ) {
+		return TT_NOTFOUND;
+	}
+
+	return function.Type;
+}
@@ -3,9 +3,6 @@
 
 #pragma once
 
-#include <string>
-#include <unordered_map>
-
 enum TTokenType {
 	TT_MULTIPLY = 0,
 	TT_PLUS = 1,
@@ -33,13 +30,28 @@ enum TTokenType {
 	TT_NOTFOUND
 };
 
+// Лексема. Текст не копируется: лексема ссылается на фрагмент входной строки
+struct CLatexToken {
+	TTokenType Type;
+	int Offset;
+	int Length;
+};
+
+// Поиск функции (\sin, \frac, ...) по имени без обратного слеша. Таблица имен построена по
+// совершенной хеш-функции, поэтому поиск - одно сравнение строк и никаких выделений памяти
 class CTokenFinder {
 public:
-	CTokenFinder();
+	static TTokenType FindFunction( const char* name, int length );
 
-	TTokenType FindFunction( const std::string& str ) const;
-	
 private:
-	std::unordered_map<std::string, TTokenType> functions;
-};
+	struct CFunction {
+		const char* Name;
+		int Length;
+		TTokenType Type;
+	};
+
+	static const int tableSize = 16;
+	static const CFunction table[tableSize];
 
+	static int hash( const char* name, int length );
+};
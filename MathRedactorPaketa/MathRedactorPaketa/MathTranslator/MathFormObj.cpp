@@ -10,6 +10,27 @@ FormulaObj::FormulaObj( TNodeType t ) : type(t)
 	params.clear(); 
 }
 
+// Дерево может быть очень глубоким (например, длинная сумма), поэтому поддеревья, которыми больше
+// никто не владеет, освобождаются без рекурсии: их потомки переносятся в общий список
+FormulaObj::~FormulaObj()
+{
+	std::vector< shared_ptr<MathObj> > pending;
+	pending.swap( params );
+	while( !pending.empty() ) {
+		shared_ptr<MathObj> node = std::move( pending.back() );
+		pending.pop_back();
+		if( node.use_count() == 1 ) {
+			FormulaObj* formula = dynamic_cast<FormulaObj*>( node.get() );
+			if( formula != 0 ) {
+				for( size_t i = 0; i < formula->params.size(); ++i ) {
+					pending.push_back( std::move( formula->params[i] ) );
+				}
+				formula->params.clear();
+			}
+		}
+	}
+}
+
 TNodeType FormulaObj::GetType() 
 { 
 	return type; 
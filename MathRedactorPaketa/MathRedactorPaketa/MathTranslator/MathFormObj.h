@@ -64,6 +64,7 @@ enum TNodeType {
 
 	NT_MAIN,        //Идентификатор того, что это корень нашего MathObj
 	NT_NOTYPE,      //Безтипная вершина
+	NT_PARAM,       //Лист (переменная или число) в CMathTree
 }; //Тип оператора в вершине дерева разбора формулы
 
 
@@ -81,6 +82,7 @@ public:
 
 	FormulaObj();
 	FormulaObj(TNodeType);
+	~FormulaObj();
 
 	TNodeType GetType();
 	void SetType(TNodeType);
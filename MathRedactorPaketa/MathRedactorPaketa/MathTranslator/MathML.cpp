@@ -1,4 +1,5 @@
 #include"MathML.h"
+#include <fstream>
 
 void CTreeBuilder::Push( TiXmlElement* elem )
 {
@@ -16,7 +17,7 @@ void CTreeBuilder::Push( TiXmlElement* elem )
 		}
 		else
 		{
-			cout << "error reading unary minus!" << endl;
+			throw invalid_argument( "Error reading unary minus" );
 		}
 	}
 	else
@@ -32,13 +33,13 @@ void CTreeBuilder::Push( TiXmlElement* elem )
 			}
 			else
 			{
-				if( elem->GetText() == string( "-" ) )
+				if( elem->GetText() != 0 && elem->GetText() == string( "-" ) )
 				{
 					uminus = true;
 				}
 				else
 				{
-					cout << "error reading binary operation!" << endl;
+					throw invalid_argument( "Error reading binary operation" );
 				}
 				return;
 			}
@@ -60,32 +61,7 @@ void CTreeBuilder::Push( TiXmlElement* elem )
 		}
 		while( operations.size() && !compare( operation, operations.top() ) )
 		{
-			shared_ptr<FormulaObj> temp ( new FormulaObj() );
-			temp->SetType( operations.top() );
-			operations.pop();
-			shared_ptr<MathObj> secondArg = terms.top();
-			terms.pop();
-			shared_ptr<MathObj> firstArg = terms.top();
-			terms.pop();
-			temp->params.push_back( firstArg );
-			temp->params.push_back( secondArg );
-			if( secondArg == NULL || firstArg == NULL )
-			{
-				vector<shared_ptr<MathObj>>::iterator argPlace = temp->params.begin();
-				++argPlace;
-				if( secondArg == NULL )
-				{
-					addArgToData( elements.top(), argPlace );
-					elements.pop();
-				}
-				--argPlace;
-				if( firstArg == NULL )
-				{
-					addArgToData( elements.top(), argPlace );
-					elements.pop();
-				}
-			}
-			terms.push( temp );
+			popOperation();
 		}
 		operations.push(operation);
 		if( invisibleMult )
@@ -96,40 +72,62 @@ void CTreeBuilder::Push( TiXmlElement* elem )
 	}
 }
 
-shared_ptr<MathObj> CTreeBuilder::GetObj()
+void CTreeBuilder::popOperation()
 {
-	while( operations.size( ) )
+	if( terms.size() < 2 )
 	{
-		shared_ptr<FormulaObj> temp (new FormulaObj( ));
-		temp->SetType( operations.top( ) );
-		operations.pop( );
-		shared_ptr<MathObj> secondArg = terms.top( );
-		terms.pop( );
-		shared_ptr<MathObj> firstArg = terms.top( );
-		terms.pop( );
-		temp->params.push_back( firstArg );
-		temp->params.push_back( secondArg );
-		if( secondArg == NULL || firstArg == NULL )
+		throw invalid_argument( "Missing operand in MML row" );
+	}
+	shared_ptr<FormulaObj> temp ( new FormulaObj() );
+	temp->SetType( operations.top() );
+	operations.pop();
+	shared_ptr<MathObj> secondArg = terms.top();
+	terms.pop();
+	shared_ptr<MathObj> firstArg = terms.top();
+	terms.pop();
+	temp->params.push_back( firstArg );
+	temp->params.push_back( secondArg );
+	if( secondArg == NULL || firstArg == NULL )
+	{
+		vector<shared_ptr<MathObj>>::iterator argPlace = temp->params.begin();
+		++argPlace;
+		if( secondArg == NULL )
 		{
-			vector<shared_ptr<MathObj>>::iterator argPlace = temp->params.begin( );
-			++argPlace;
-			if( secondArg == NULL )
-			{
-				addArgToData( elements.top( ), argPlace );
-				elements.pop( );
-			}
-			--argPlace;
-			if( firstArg == NULL )
-			{
-				addArgToData( elements.top( ), argPlace );
-				elements.pop( );
-			}
+			addArgToData( GetArg(), argPlace );
+			elements.pop();
+		}
+		--argPlace;
+		if( firstArg == NULL )
+		{
+			addArgToData( GetArg(), argPlace );
+			elements.pop();
 		}
-		terms.push( temp );
+	}
+	terms.push( temp );
+}
+
+shared_ptr<MathObj> CTreeBuilder::GetObj()
+{
+	while( operations.size( ) )
+	{
+		popOperation();
+	}
+	if( terms.size() != 1 || uminus )
+	{
+		throw invalid_argument( "Incomplete MML row" );
 	}
 	return terms.top();
 }
 
+TiXmlElement* CTreeBuilder::GetArg()
+{
+	if( elements.empty() )
+	{
+		throw invalid_argument( "Missing operand in MML row" );
+	}
+	return elements.top();
+}
+
 int priority( TNodeType a )
 {
 	switch( a )
@@ -294,6 +292,10 @@ bool compare( TNodeType a, TNodeType b )
 
 TNodeType readBinarOperation( TiXmlElement* elem )
 {
+	if( elem->GetText( ) == 0 )
+	{
+		throw invalid_argument( "Empty MML operator" );
+	}
 	string id( elem->GetText( ) );
 	if( id == "+" )
 	{
@@ -350,7 +352,27 @@ void MathMLParser::Pars(const std::string file)
 	{
 		cout << "Failed to load MML-file\n";
 	}
+	parsDocument(doc);
+}
+
+void MathMLParser::ParsString(const std::string& text)
+{
+	TiXmlDocument doc;
+	doc.Parse(text.c_str());
+	if (doc.Error())
+	{
+		throw invalid_argument(doc.ErrorDesc());
+	}
+	parsDocument(doc);
+}
+
+void MathMLParser::parsDocument(TiXmlDocument& doc)
+{
 	TiXmlElement* elem (doc.FirstChildElement());
+	if (elem == 0 || elem->FirstChildElement() == 0)
+	{
+		throw invalid_argument("Empty MML document");
+	}
 	elem = (elem->FirstChildElement());
 	root = shared_ptr<FormulaObj>(new FormulaObj());
 	((FormulaObj*)root.get())->SetType(NT_MAIN);
@@ -361,6 +383,10 @@ void MathMLParser::Pars(const std::string file)
 
 void addArgToData( TiXmlElement* elem, vector<shared_ptr<MathObj>>::iterator place )
 {
+	if( elem == 0 )
+	{
+		throw invalid_argument( "Missing MML argument" );
+	}
 	if( elem->Value( ) == string( "msqrt" ) )
 	{
 		shared_ptr<FormulaObj> child (new FormulaObj( ));
@@ -405,6 +431,10 @@ void addArgToData( TiXmlElement* elem, vector<shared_ptr<MathObj>>::iterator pla
 	}
 	if( elem->Value() == string( "mi" ) || elem->Value() == string( "mn" ) )
 	{
+		if( elem->GetText() == 0 )
+		{
+			throw invalid_argument( "Empty MML identifier" );
+		}
 		shared_ptr<ParamObj> arg (new ParamObj( ));
 		*place = arg;
 		arg->SetVal( elem->GetText() );
@@ -419,7 +449,9 @@ void addArgToData( TiXmlElement* elem, vector<shared_ptr<MathObj>>::iterator pla
 	if( elem->Value() == string( "mfenced" ) )
 	{
 		TiXmlElement* childElem (elem->FirstChildElement( ));
-		if( elem->Attribute( "open" ) == string( "|" ) && elem->Attribute( "close" ) == string( "|" ) )
+		const char* open = elem->Attribute( "open" );
+		const char* close = elem->Attribute( "close" );
+		if( open != 0 && close != 0 && open == string( "|" ) && close == string( "|" ) )
 		{
 			shared_ptr<FormulaObj> child (new FormulaObj( ));
 			*place = child;
@@ -463,174 +495,189 @@ void addRowToData( TiXmlElement* elem, vector<shared_ptr<MathObj>>::iterator pla
 
 void MathMLParser::Save(std::string outputFileName )
 {
-    TiXmlDocument doc;
-    TiXmlDeclaration* decl ( new TiXmlDeclaration( "1.0", "UTF-8", "" ) );
-    doc.LinkEndChild( decl ); //создали декларационную часть xml документа
-    
     shared_ptr<MathObj> obj = root;
     if( static_cast< FormulaObj* >( obj.get() )->GetType() != NT_MAIN )
     {
         std::cerr << "Ошибка построения дерева разбора: Корень должен быть NT_MAIN!" << std::endl;
         return;
     }
-    
-	TiXmlElement* element (new TiXmlElement( "math" ));
-    element->SetAttribute( "xmlns", "http://www.w3.org/1998/Math/MathML" );
-    doc.LinkEndChild( element ); //создали главную часть, в которой записана формула
-    saveTreeToXml( element, static_cast< FormulaObj* >( obj.get() )->params[0], true );
 
-    doc.SaveFile( outputFileName.data() );
+    CMathTree tree;
+    tree.Assign( obj );
+    Save( outputFileName, tree );
+}
+
+void MathMLParser::Save( std::string outputFileName, const CMathTree& tree )
+{
+    string output;
+    SaveToString( tree, output );
+    ofstream ofs( outputFileName, ios::out );
+    ofs << output;
 }
 
-void linkNewElem( TiXmlElement* parent, const char* param, const char* val )
+void MathMLParser::SaveToString( const CMathTree& tree, std::string& output, bool singleLine )
 {
-    TiXmlElement* element (new TiXmlElement( param ));
-    TiXmlText* text ( new TiXmlText( val ) );
-    element->LinkEndChild( text );
-    parent->LinkEndChild( element );
+    output.clear();
+    CXmlTextWriter xml( output, singleLine );
+    xml.WriteDeclaration();
+    xml.OpenElement( "math" );
+    xml.AddAttribute( "xmlns", "http://www.w3.org/1998/Math/MathML" );
+    xml.OpenElement( "mrow" );
+    CMathMLWriter writer( xml );
+    tree.Walk( writer );
+    xml.CloseElement();
+    xml.CloseElement();
 }
 
-void saveTreeToXml( TiXmlElement* pElem, shared_ptr<MathObj> obj, bool isNewRow )
+void CMathMLWriter::VisitParam( const CMathTree& tree, int node )
 {
-    if( isNewRow ) {
-        TiXmlElement* element (new TiXmlElement( "mrow" ));
-        pElem->LinkEndChild( element );
-        pElem = element;
-        isNewRow = false;
+    const char* val = tree.GetValue( node );
+    if( val[0] < 48 || val[0] > 57 ) // если значение начинается с буквы, то - идентификатор 
+    {
+        xml.WriteTextElement( "mi", val );
+    }
+    else {
+        xml.WriteTextElement( "mn", val );
     }
+}
 
-    std::string objType = typeid( *obj ).name();
+bool CMathMLWriter::EnterFormula( const CMathTree& tree, int node )
+{
+    TNodeType type = tree.GetType( node );
 
-    if( objType == "class ParamObj" ) 
+    switch( type )
     {
-        std::string val = static_pointer_cast< ParamObj >( obj )->GetVal();
-        if( val[0] < 48 || val[0] > 57 ) // если значение начинается с буквы, то - идентификатор 
-        {
-            linkNewElem( pElem, "mi", val.c_str() );
+    case NT_PLUS:
+    case NT_UMINUS:
+    case NT_MINUS:
+    case NT_MULTNCM: // TODO поправить в будущем, пока как обычное умножение
+    case NT_MULTCM:
+    case NT_EQUAL:
+    case NT_LESS:
+    case NT_GREAT:
+    case NT_NEQUAL:
+    case NT_LESSEQ:
+    case NT_GREATEQ:
+    case NT_APPROX:
+    case NT_PLUSMINUS:
+        // потомки пишутся в ту же строку
+        if( type == NT_UMINUS ) {
+            xml.WriteTextElement( "mo", "-" );
         }
-        else {
-            linkNewElem( pElem, "mn", val.c_str() );
+        return true;
+
+    case NT_DIV:
+        xml.OpenElement( "mfrac" );
+        return true;
+
+    case NT_POW:
+        xml.OpenElement( "msup" );
+        return true;
+
+    case NT_ROOT:
+        if( tree.GetChildrenCount( node ) != 1 ) {
+            throw invalid_argument( "Root with index is not supported in MathML" );
         }
+        xml.OpenElement( "msqrt" );
+        return true;
+
+    default:
+        // не поддерживаемый (пока) тип оператора
+        throw invalid_argument( "Operation is not supported in MathML" );
     }
-    else if( objType == "class FormulaObj" )
+}
+
+void CMathMLWriter::LeaveFormula( const CMathTree& tree, int node )
+{
+    switch( tree.GetType( node ) )
+    {
+    case NT_DIV:
+    case NT_POW:
+    case NT_ROOT:
+        xml.CloseElement();
+        break;
+    default:
+        break;
+    }
+}
+
+bool CMathMLWriter::BeforeChild( const CMathTree& tree, int parent, int index )
+{
+    int last = tree.GetChildrenCount( parent ) - 1;
+    switch( tree.GetType( parent ) )
     {
-        shared_ptr<FormulaObj> node = static_pointer_cast< FormulaObj >( obj );
-        TNodeType type = node->GetType();
-        std::vector<shared_ptr<MathObj>>::iterator it = node->params.begin( );
-        std::vector<shared_ptr<MathObj>>::const_iterator itLast = node->params.end( ) - 1;
-        TiXmlElement* element;
-
-        switch( type )
-        {
-        case NT_PLUS:
-            for( it; it != itLast; ++it )
-            {
-                saveTreeToXml( pElem, *it, isNewRow );
-                linkNewElem( pElem, "mo", "+" );
-            }
-            saveTreeToXml( pElem, *it, isNewRow );
-            break;
-
-        case NT_UMINUS:
-            linkNewElem( pElem, "mo", "-" );
-            saveTreeToXml( pElem, *it, isNewRow );
-            break;
-            
-        case NT_MINUS:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "-" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_MULTNCM: // TODO поправить в будущем, пока как обычное умножение
-            for( it; it != itLast; ++it )
-            {
-                saveTreeToXml( pElem, *it, isNewRow );
-            }
-            saveTreeToXml( pElem, *it, isNewRow );
-            break;
-
-        case NT_DIV:
-            element = (new TiXmlElement( "mfrac" ));
-            pElem->LinkEndChild( element );
-            saveTreeToXml( element, *it, true );
-            saveTreeToXml( element, *itLast, true );
-            break;
-
-        case NT_POW:
-            element = (new TiXmlElement( "msup" ));
-            pElem->LinkEndChild( element );
-            saveTreeToXml( element, *it, false );
-            saveTreeToXml( element, *itLast, false );
-            break;
-
-        case NT_ROOT:
-            if( itLast == it )
-            {
-				element = (new TiXmlElement("msqrt"));
-                pElem->LinkEndChild( element );
-                saveTreeToXml( element, *it, false );
-            }
-            break;
-
-        case NT_MULTCM:
-            for( it; it != itLast; ++it )
-            {
-                saveTreeToXml( pElem, *it, isNewRow );
-            }
-            saveTreeToXml( pElem, *it, isNewRow );
-            break;
-
-        case NT_EQUAL:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "=" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_LESS:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "<" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_GREAT:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", ">" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_NEQUAL:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "≠" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_LESSEQ:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "\\leq" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_GREATEQ:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "\\geq" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_APPROX:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "≈" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        case NT_PLUSMINUS:
-            saveTreeToXml( pElem, *it, isNewRow );
-            linkNewElem( pElem, "mo", "±" );
-            saveTreeToXml( pElem, *itLast, isNewRow );
-            break;
-
-        default:
-            std::cerr << "Ошибка, не поддерживаемый (пока) тип оператора, код: " << type << std::endl;
+    case NT_PLUS:
+    case NT_MULTNCM:
+    case NT_MULTCM:
+    case NT_ROOT:
+        break;
+
+    case NT_UMINUS:
+        if( index != 0 ) {
+            return false;
+        }
+        break;
+
+    case NT_DIV:
+        // числитель и знаменатель пишутся каждый в свою строку
+        if( index != 0 && index != last ) {
+            return false;
+        }
+        xml.OpenElement( "mrow" );
+        return true;
+
+    default:
+        // бинарные операции: пишутся только первый и последний операнды
+        if( index != 0 && index != last ) {
+            return false;
         }
+        break;
     }
-}
\ No newline at end of file
+    return true;
+}
+
+void CMathMLWriter::AfterChild( const CMathTree& tree, int parent, int index )
+{
+    if( tree.GetType( parent ) == NT_DIV ) {
+        xml.CloseElement();
+    }
+    if( index == tree.GetChildrenCount( parent ) - 1 ) {
+        return;
+    }
+
+    switch( tree.GetType( parent ) )
+    {
+    case NT_PLUS:
+        xml.WriteTextElement( "mo", "+" );
+        break;
+    case NT_MINUS:
+        xml.WriteTextElement( "mo", "-" );
+        break;
+    case NT_EQUAL:
+        xml.WriteTextElement( "mo", "=" );
+        break;
+    case NT_LESS:
+        xml.WriteTextElement( "mo", "<" );
+        break;
+    case NT_GREAT:
+        xml.WriteTextElement( "mo", ">" );
+        break;
+    case NT_NEQUAL:
+        xml.WriteTextElement( "mo", "≠" );
+        break;
+    case NT_LESSEQ:
+        xml.WriteTextElement( "mo", "\\leq" );
+        break;
+    case NT_GREATEQ:
+        xml.WriteTextElement( "mo", "\\geq" );
+        break;
+    case NT_APPROX:
+        xml.WriteTextElement( "mo", "≈" );
+        break;
+    case NT_PLUSMINUS:
+        xml.WriteTextElement( "mo", "±" );
+        break;
+    default:
+        break;
+    }
+}
@@ -1,12 +1,16 @@
 ﻿#include "stdafx.h"
 #include "MathFormObj.h"
+#include "MathTree.h"
 #include "targetver.h"
 #include "tinystr.h"
 #include "tinyxml.h"
+#include "XmlTextWriter.h"
 #include <string>
 #include <iostream>
 #include <stack>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 using namespace std;
 
@@ -18,7 +22,14 @@ public:
 	void SetData(shared_ptr<MathObj> newRoot){ root = newRoot; }
 	shared_ptr<MathObj> GetData(){ return root; }
 	void Pars(const std::string file);
+	void ParsString(const std::string& text); // разбирает MathML из строки, а не из файла; при ошибке бросает std::invalid_argument
     void Save(std::string file);
+    // Записать компактное дерево формулы в файл MathML
+    static void Save(std::string file, const CMathTree& tree);
+    // Записать компактное дерево формулы в строку MathML, singleLine - без переносов строк
+    static void SaveToString(const CMathTree& tree, std::string& output, bool singleLine = false);
+private:
+	void parsDocument(TiXmlDocument& doc);
 };
 
 class CTreeBuilder
@@ -30,9 +41,12 @@ class CTreeBuilder
 	bool uminus = false;
 public:
 	bool IsTree(){ return terms.top() != 0; }
+	// Собирает строку в дерево. Если в строке не хватает операндов, бросает std::invalid_argument
 	shared_ptr<MathObj> GetObj( );
-	TiXmlElement* GetArg(){ return elements.top(); }
+	TiXmlElement* GetArg();
 	void Push( TiXmlElement* elem );
+private:
+	void popOperation(); // снимает со стека операцию вместе с ее операндами
 };
 
 int priority( TNodeType a );
@@ -45,6 +59,18 @@ void addArgToData( TiXmlElement* elem, vector<shared_ptr<MathObj>>::iterator pla
 
 void addRowToData( TiXmlElement* elem, vector<shared_ptr<MathObj>>::iterator place );
 
-void saveTreeToXml( TiXmlElement*, shared_ptr<MathObj>, bool ); // преобразует дерево разбора в xml документ, начиная с определенной вершины
+// Обход дерева, записывающий его в текст MathML: узлы пишутся внутрь текущего открытого элемента
+class CMathMLWriter : public CMathTreeVisitor
+{
+	CXmlTextWriter& xml;
+public:
+	explicit CMathMLWriter( CXmlTextWriter& _xml ) : xml( _xml ) {}
+
+	virtual void VisitParam( const CMathTree& tree, int node );
+	virtual bool EnterFormula( const CMathTree& tree, int node );
+	virtual void LeaveFormula( const CMathTree& tree, int node );
+	virtual bool BeforeChild( const CMathTree& tree, int parent, int index );
+	virtual void AfterChild( const CMathTree& tree, int parent, int index );
+};
 
 void linkNewElem( TiXmlElement*, shared_ptr<char>, shared_ptr<std::string> ); // добавляет в xml документе новый элемент с заданным тегом и значением
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "ConvertOM.h"
 #include "MathML.h"
 #include "ConvertLatex.h"
+#include "BatchConverter.h"
 
 // ConverterMemory.cpp
 //extern HANDLE ConverterHeap;
@@ -117,7 +118,20 @@ void MTConvert( char* inputParam, char* inputFileName, char* outputParam, char*
 //    }
 //}
 
-int main() {
+// MathTranslator batch <входной формат> <файл или папка> <выходной формат> <файл или папка> [потоки]
+// Форматы: latex, mathml, omath. Без аргументов конвертирует пример inputLatex1.txt
+int main( int argc, char* argv[] ) {
+	if( argc >= 6 && std::string( argv[1] ) == "batch" ) {
+		TSupportedFormats inputFormat;
+		TSupportedFormats outputFormat;
+		if( !ParseFormatName( argv[2], inputFormat ) || !ParseFormatName( argv[4], outputFormat ) ) {
+			std::cerr << "Unknown format, expected latex, mathml or omath" << std::endl;
+			return 2;
+		}
+		int threadsCount = argc > 6 ? atoi( argv[6] ) : 0;
+		return ConvertBatch( argv[3], inputFormat, outputFormat, argv[5], std::cout, threadsCount ) == 0 ? 0 : 1;
+	}
+
 	MTConvert("latex", "inputLatex1.txt", "latex", "output");
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,289 @@
+﻿// Описание: Реализация компактного дерева формулы
+
+#include "MathTree.h"
+#include <assert.h>
+#include <string.h>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+void CMathStringPool::Clear()
+{
+	chars.clear();
+	offsets.assign( 1, 0 );
+	slots.assign( 16, -1 );
+}
+
+unsigned int CMathStringPool::Hash( const char* str, int length )
+{
+	// FNV-1a
+	unsigned int result = 2166136261U;
+	for( int i = 0; i < length; ++i ) {
+		result = ( result ^ static_cast<unsigned char>( str[i] ) ) * 16777619U;
+	}
+	return result;
+}
+
+int CMathStringPool::findSlot( const char* str, int length ) const
+{
+	size_t mask = slots.size() - 1;
+	for( size_t slot = Hash( str, length ) & mask; ; slot = ( slot + 1 ) & mask ) {
+		int id = slots[slot];
+		if( id < 0 || ( GetLength( id ) == length && memcmp( GetString( id ), str, length ) == 0 ) ) {
+			return static_cast<int>( slot );
+		}
+	}
+}
+
+void CMathStringPool::grow()
+{
+	slots.assign( slots.size() * 2, -1 );
+	for( int id = 0; id < GetCount(); ++id ) {
+		slots[findSlot( GetString( id ), GetLength( id ) )] = id;
+	}
+}
+
+int CMathStringPool::Intern( const char* str, int length )
+{
+	int slot = findSlot( str, length );
+	if( slots[slot] >= 0 ) {
+		return slots[slot];
+	}
+
+	int id = GetCount();
+	chars.insert( chars.end(), str, str + length );
+	chars.push_back( '\0' );
+	offsets.push_back( static_cast<int>( chars.size() ) );
+	slots[slot] = id;
+
+	// Таблица заполнена не больше чем наполовину
+	if( 2 * GetCount() > static_cast<int>( slots.size() ) ) {
+		grow();
+	}
+	return id;
+}
+
+void CMathTree::Clear()
+{
+	nodes.clear();
+	extraChildren.clear();
+	strings.Clear();
+	slots.assign( 16, -1 );
+	root = -1;
+}
+
+unsigned int CMathTree::combineHash( unsigned int seed, unsigned int value )
+{
+	return seed ^ ( value + 0x9e3779b9U + ( seed << 6 ) + ( seed >> 2 ) );
+}
+
+int CMathTree::findSlot( unsigned int hash, TNodeType type, int value, const int* children, int count ) const
+{
+	size_t mask = slots.size() - 1;
+	for( size_t slot = hash & mask; ; slot = ( slot + 1 ) & mask ) {
+		int id = slots[slot];
+		if( id < 0 ) {
+			return static_cast<int>( slot );
+		}
+		// Потомки уже без повторов, поэтому достаточно сравнить их индексы
+		const CMathNode& node = nodes[id];
+		if( node.Hash == hash && node.Type == type && node.Value == value && node.ChildrenCount == count
+			&& ( count == 0 || memcmp( GetChildren( id ), children, count * sizeof( int ) ) == 0 ) )
+		{
+			return static_cast<int>( slot );
+		}
+	}
+}
+
+void CMathTree::growSlots()
+{
+	slots.assign( slots.size() * 2, -1 );
+	for( int id = 0; id < GetNodesCount(); ++id ) {
+		const CMathNode& node = nodes[id];
+		slots[findSlot( node.Hash, node.Type, node.Value, GetChildren( id ), node.ChildrenCount )] = id;
+	}
+}
+
+int CMathTree::addNode( const CMathNode& node, const int* children )
+{
+	int slot = findSlot( node.Hash, node.Type, node.Value, children, node.ChildrenCount );
+	if( slots[slot] >= 0 ) {
+		return slots[slot];
+	}
+
+	int id = GetNodesCount();
+	nodes.push_back( node );
+	if( node.ChildrenCount <= CMathNode::InlineChildren ) {
+		for( int i = 0; i < node.ChildrenCount; ++i ) {
+			nodes.back().Children[i] = children[i];
+		}
+	} else {
+		nodes.back().Children[0] = static_cast<int>( extraChildren.size() );
+		extraChildren.insert( extraChildren.end(), children, children + node.ChildrenCount );
+	}
+	slots[slot] = id;
+
+	// Таблица заполнена не больше чем наполовину
+	if( 2 * GetNodesCount() > static_cast<int>( slots.size() ) ) {
+		growSlots();
+	}
+	return id;
+}
+
+int CMathTree::AddParam( const char* str, int length )
+{
+	CMathNode node;
+	node.Type = NT_PARAM;
+	node.ChildrenCount = 0;
+	node.Value = strings.Intern( str, length );
+	node.Hash = combineHash( NT_PARAM, CMathStringPool::Hash( str, length ) );
+	return addNode( node, 0 );
+}
+
+int CMathTree::AddFormula( TNodeType type, const int* children, int count )
+{
+	CMathNode node;
+	node.Type = type;
+	node.ChildrenCount = count;
+	node.Value = -1;
+	node.Hash = static_cast<unsigned int>( type );
+	for( int i = 0; i < count; ++i ) {
+		assert( children[i] >= 0 && children[i] < GetNodesCount() );
+		node.Hash = combineHash( node.Hash, nodes[children[i]].Hash );
+	}
+	return addNode( node, children );
+}
+
+int CMathTree::AddFormula( TNodeType type, int first, int second )
+{
+	int children[2] = { first, second };
+	return AddFormula( type, children, 2 );
+}
+
+const int* CMathTree::GetChildren( int node ) const
+{
+	const CMathNode& mathNode = nodes[node];
+	if( mathNode.ChildrenCount <= CMathNode::InlineChildren ) {
+		return mathNode.Children;
+	}
+	return &extraChildren[mathNode.Children[0]];
+}
+
+void CMathTree::Walk( int node, CMathTreeVisitor& visitor ) const
+{
+	if( IsParam( node ) ) {
+		visitor.VisitParam( *this, node );
+		return;
+	}
+	if( !visitor.EnterFormula( *this, node ) ) {
+		return;
+	}
+
+	// Стек операций, которые сейчас обходятся, и номер следующего потомка для каждой
+	vector< pair<int, int> > stack;
+	stack.push_back( make_pair( node, 0 ) );
+	while( !stack.empty() ) {
+		int parent = stack.back().first;
+		int index = stack.back().second;
+		if( index == GetChildrenCount( parent ) ) {
+			visitor.LeaveFormula( *this, parent );
+			stack.pop_back();
+			if( !stack.empty() ) {
+				visitor.AfterChild( *this, stack.back().first, stack.back().second - 1 );
+			}
+			continue;
+		}
+
+		++stack.back().second;
+		if( !visitor.BeforeChild( *this, parent, index ) ) {
+			continue;
+		}
+
+		int child = GetChild( parent, index );
+		if( IsParam( child ) ) {
+			visitor.VisitParam( *this, child );
+		} else if( visitor.EnterFormula( *this, child ) ) {
+			stack.push_back( make_pair( child, 0 ) );
+			continue;
+		}
+		visitor.AfterChild( *this, parent, index );
+	}
+}
+
+void CMathTree::Assign( shared_ptr<MathObj> mathObj )
+{
+	Clear();
+
+	FormulaObj* main = dynamic_cast<FormulaObj*>( mathObj.get() );
+	if( main == 0 || main->GetType() != NT_MAIN || main->params.size() != 1 ) {
+		throw invalid_argument( "Root of formula must be NT_MAIN" );
+	}
+
+	// Обход в глубину без рекурсии: узел добавляется, когда добавлены все его потомки
+	struct CFrame {
+		MathObj* Obj;
+		size_t NextChild;
+	};
+	vector<CFrame> stack;
+	vector<int> built; // Индексы построенных потомков для узлов в стеке
+	CFrame first = { main->params[0].get(), 0 };
+	stack.push_back( first );
+	while( !stack.empty() ) {
+		CFrame& frame = stack.back();
+		if( frame.Obj == 0 ) {
+			throw invalid_argument( "Empty node in formula" );
+		}
+
+		FormulaObj* formula = dynamic_cast<FormulaObj*>( frame.Obj );
+		if( formula == 0 ) {
+			const string& val = static_cast<ParamObj*>( frame.Obj )->GetVal();
+			stack.pop_back();
+			built.push_back( AddParam( val ) );
+			continue;
+		}
+
+		if( frame.NextChild < formula->params.size() ) {
+			CFrame child = { formula->params[frame.NextChild].get(), 0 };
+			++frame.NextChild;
+			stack.push_back( child );
+			continue;
+		}
+
+		int count = static_cast<int>( formula->params.size() );
+		int node = AddFormula( formula->GetType(), count > 0 ? &built[built.size() - count] : 0, count );
+		built.resize( built.size() - count );
+		built.push_back( node );
+		stack.pop_back();
+	}
+
+	assert( built.size() == 1 );
+	root = built[0];
+}
+
+shared_ptr<MathObj> CMathTree::ToMathObj() const
+{
+	// Потомки всегда имеют меньшие индексы, поэтому достаточно одного прохода по массиву.
+	// Общие поддеревья остаются общими и в MathObj
+	vector< shared_ptr<MathObj> > objs( nodes.size() );
+	for( int i = 0; i < GetNodesCount(); ++i ) {
+		if( IsParam( i ) ) {
+			objs[i] = shared_ptr<ParamObj>( new ParamObj( string( GetValue( i ), GetValueLength( i ) ) ) );
+			continue;
+		}
+
+		shared_ptr<FormulaObj> formula( new FormulaObj( GetType( i ) ) );
+		const int* children = GetChildren( i );
+		formula->params.reserve( GetChildrenCount( i ) );
+		for( int j = 0; j < GetChildrenCount( i ); ++j ) {
+			formula->params.push_back( objs[children[j]] );
+		}
+		objs[i] = formula;
+	}
+
+	shared_ptr<FormulaObj> main( new FormulaObj( NT_MAIN ) );
+	if( root >= 0 ) {
+		main->params.push_back( objs[root] );
+	}
+	return main;
+}
@@ -0,0 +1,128 @@
+﻿// Описание: Компактное дерево формулы. Узлы хранятся в одном массиве и ссылаются на потомков по индексам,
+// тип узла хранится в самом узле, строки листьев лежат в общем пуле без повторов.
+// Одинаковые поддеревья хранятся один раз (hash-consing), так что дерево на самом деле - ориентированный
+// ациклический граф, а равенство поддеревьев проверяется сравнением индексов.
+// Обходится без RTTI и без выделения памяти на каждый узел
+
+#pragma once
+
+#include "MathFormObj.h"
+#include <string>
+#include <vector>
+
+// Пул строк: одинаковые строки хранятся один раз и получают один номер
+class CMathStringPool {
+public:
+	CMathStringPool() { Clear(); }
+
+	void Clear();
+
+	// Номер строки в пуле. Если такой строки еще нет, она добавляется
+	int Intern( const char* str, int length );
+
+	int GetCount() const { return static_cast<int>( offsets.size() ) - 1; }
+	// Строка, завершенная нулем
+	const char* GetString( int id ) const { return &chars[offsets[id]]; }
+	int GetLength( int id ) const { return offsets[id + 1] - offsets[id] - 1; }
+
+	// Хеш строки, не зависит от содержимого пула
+	static unsigned int Hash( const char* str, int length );
+
+private:
+	std::vector<char> chars; // Строки подряд, каждая с завершающим нулем
+	std::vector<int> offsets; // Начало каждой строки в chars и в конце - размер chars
+	std::vector<int> slots; // Хеш-таблица с открытой адресацией: номер строки или -1
+
+	int findSlot( const char* str, int length ) const;
+	void grow();
+};
+
+// Узел дерева. Для листа Type == NT_PARAM, а Value - номер строки в пуле.
+// Если потомков не больше InlineChildren, их индексы лежат прямо в узле,
+// иначе Children[0] - начало списка потомков в общем массиве дерева
+struct CMathNode {
+	static const int InlineChildren = 3;
+
+	TNodeType Type;
+	int ChildrenCount;
+	int Value;
+	// Структурный хеш поддерева: зависит только от типов и строк, поэтому совпадает
+	// у одинаковых поддеревьев и из разных деревьев
+	unsigned int Hash;
+	int Children[InlineChildren];
+};
+
+class CMathTree;
+
+// Посетитель дерева для CMathTree::Walk. Для листа вызывается VisitParam. Для операции вызывается EnterFormula,
+// затем для каждого потомка BeforeChild, обход потомка и AfterChild, в конце LeaveFormula.
+// Если EnterFormula вернул false, потомки и LeaveFormula пропускаются; если BeforeChild вернул false,
+// пропускается этот потомок (и AfterChild для него)
+class CMathTreeVisitor {
+public:
+	virtual ~CMathTreeVisitor() {}
+
+	virtual void VisitParam( const CMathTree& tree, int node ) {}
+	virtual bool EnterFormula( const CMathTree& tree, int node ) { return true; }
+	virtual void LeaveFormula( const CMathTree& tree, int node ) {}
+	virtual bool BeforeChild( const CMathTree& tree, int parent, int index ) { return true; }
+	virtual void AfterChild( const CMathTree& tree, int parent, int index ) {}
+};
+
+// Дерево формулы. Узлы добавляются снизу вверх: потомки всегда создаются раньше родителя,
+// поэтому индекс потомка меньше индекса родителя. Корень не содержит NT_MAIN, это сама формула.
+// Если такой же узел уже есть, AddParam и AddFormula возвращают его индекс, а не создают новый
+class CMathTree {
+public:
+	CMathTree() { Clear(); }
+
+	void Clear();
+
+	int AddParam( const char* str, int length );
+	int AddParam( const std::string& str ) { return AddParam( str.data(), static_cast<int>( str.length() ) ); }
+	int AddFormula( TNodeType type, const int* children, int count );
+	int AddFormula( TNodeType type, int child ) { return AddFormula( type, &child, 1 ); }
+	int AddFormula( TNodeType type, int first, int second );
+
+	int GetRoot() const { return root; }
+	void SetRoot( int node ) { root = node; }
+	bool IsEmpty() const { return root < 0; }
+
+	int GetNodesCount() const { return static_cast<int>( nodes.size() ); }
+	const CMathNode& GetNode( int node ) const { return nodes[node]; }
+	TNodeType GetType( int node ) const { return nodes[node].Type; }
+	bool IsParam( int node ) const { return nodes[node].Type == NT_PARAM; }
+	unsigned int GetHash( int node ) const { return nodes[node].Hash; }
+	// Поддеревья одного дерева равны структурно тогда и только тогда, когда совпадают их индексы
+	bool IsEqual( int first, int second ) const { return first == second; }
+
+	int GetChildrenCount( int node ) const { return nodes[node].ChildrenCount; }
+	// Указатель действителен, пока в дерево не добавляются узлы
+	const int* GetChildren( int node ) const;
+	int GetChild( int node, int index ) const { return GetChildren( node )[index]; }
+
+	// Строка листа, завершенная нулем
+	const char* GetValue( int node ) const { return strings.GetString( nodes[node].Value ); }
+	int GetValueLength( int node ) const { return strings.GetLength( nodes[node].Value ); }
+
+	// Обход в глубину без рекурсии, поэтому годится для сколь угодно глубоких формул
+	void Walk( CMathTreeVisitor& visitor ) const { Walk( root, visitor ); }
+	void Walk( int node, CMathTreeVisitor& visitor ) const;
+
+	// Построить дерево по MathObj с корнем NT_MAIN. Бросает std::invalid_argument, если в дереве есть пустые узлы
+	void Assign( shared_ptr<MathObj> mathObj );
+	// Построить MathObj с корнем NT_MAIN
+	shared_ptr<MathObj> ToMathObj() const;
+
+private:
+	std::vector<CMathNode> nodes;
+	std::vector<int> extraChildren; // Потомки узлов, у которых их больше InlineChildren
+	CMathStringPool strings;
+	std::vector<int> slots; // Хеш-таблица узлов с открытой адресацией: номер узла или -1
+	int root;
+
+	static unsigned int combineHash( unsigned int seed, unsigned int value );
+	int findSlot( unsigned int hash, TNodeType type, int value, const int* children, int count ) const;
+	int addNode( const CMathNode& node, const int* children );
+	void growSlots();
+};
@@ -1,79 +1,312 @@
-﻿// Автор: Азат Давлетшин
-// Описание: Таблица shift, reduce переходов для LR-парсера. Построена с помощью Bison. В файле parser.y описана грамматика.
-// В файле parser.bison.txt отладочный вывод Bison'а, на основе которого построена таблица
+﻿// Файл сгенерирован скриптом GenerateParsingTable.py по грамматике parser.y. Не редактируйте его вручную:
+// измените parser.y и пересоберите проект (или запустите скрипт)
 
-#include <vector>
+#include "ParsingTable.h"
+#include "LatexTokens.h"
 
-using namespace std;
+static_assert( ParsingTableWidth == TT_EOF + 1, "ParsingTable.cpp is out of date, run GenerateParsingTable.py" );
 
-extern const int Err = INT_MAX;
+const signed char ParsingTable[ParsingTableHeight * ParsingTableWidth] = {
+	/*   *,   +,   -,   [,   ],   ^,   _,   {,   },PROD, SUM, COT, TAN, COS, SIN,  ID,FRAC,SQRT,   (,   ), Exp, EOF */
+	// 0
+	//   $accept: . Exp $end
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  12,   0,
+	// 1
+	//   Exp: '-' . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  13,   0,
+	// 2
+	//   Exp: PROD . '_' '{' Exp '}' '^' '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,   0,  14,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 3
+	//   Exp: SUM . '_' '{' Exp '}' '^' '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,   0,  15,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 4
+	//   Exp: COT . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  16,   0,
+	// 5
+	//   Exp: TAN . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  17,   0,
+	// 6
+	//   Exp: COS . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  18,   0,
+	// 7
+	//   Exp: SIN . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  19,   0,
+	// 8
+	//   Exp: ID .
+	    -6,  -6,  -6,   0,  -6,  -6,   0,   0,  -6,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -6,   0,  -6,
+	// 9
+	//   Exp: FRAC . '{' Exp '}' '{' Exp '}'
+	     0,   0,   0,   0,   0,   0,   0,  20,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 10
+	//   Exp: SQRT . '{' Exp '}'
+	//   Exp: SQRT . '[' Exp ']' '{' Exp '}'
+	     0,   0,   0,  21,   0,   0,   0,  22,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 11
+	//   Exp: "(" . Exp ")"
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  23,   0,
+	// 12
+	//   $accept: Exp . $end
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	    24,  25,  26,   0,   0,  27,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  28,
+	// 13
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: '-' Exp .
+	//   Exp: Exp . '^' '{' Exp '}'
+	    -5,  -5,  -5,   0,  -5,  27,   0,   0,  -5,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -5,   0,  -5,
+	// 14
+	//   Exp: PROD '_' . '{' Exp '}' '^' '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,   0,   0,  29,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 15
+	//   Exp: SUM '_' . '{' Exp '}' '^' '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,   0,   0,  30,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 16
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: COT Exp .
+	    24, -16, -16,   0, -16,  27,   0,   0, -16,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -16,   0, -16,
+	// 17
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: TAN Exp .
+	    24, -15, -15,   0, -15,  27,   0,   0, -15,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -15,   0, -15,
+	// 18
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: COS Exp .
+	    24, -14, -14,   0, -14,  27,   0,   0, -14,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -14,   0, -14,
+	// 19
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: SIN Exp .
+	    24, -13, -13,   0, -13,  27,   0,   0, -13,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -13,   0, -13,
+	// 20
+	//   Exp: FRAC '{' . Exp '}' '{' Exp '}'
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  31,   0,
+	// 21
+	//   Exp: SQRT '[' . Exp ']' '{' Exp '}'
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  32,   0,
+	// 22
+	//   Exp: SQRT '{' . Exp '}'
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  33,   0,
+	// 23
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: "(" Exp . ")"
+	    24,  25,  26,   0,   0,  27,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  34,   0,   0,
+	// 24
+	//   Exp: Exp '*' . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  35,   0,
+	// 25
+	//   Exp: Exp '+' . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  36,   0,
+	// 26
+	//   Exp: Exp '-' . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  37,   0,
+	// 27
+	//   Exp: Exp '^' . '{' Exp '}'
+	     0,   0,   0,   0,   0,   0,   0,  38,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 28
+	//   $accept: Exp $end .
+	     0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 29
+	//   Exp: PROD '_' '{' . Exp '}' '^' '{' Exp '}' Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  39,   0,
+	// 30
+	//   Exp: SUM '_' '{' . Exp '}' '^' '{' Exp '}' Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  40,   0,
+	// 31
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: FRAC '{' Exp . '}' '{' Exp '}'
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	    24,  25,  26,   0,   0,  27,   0,   0,  41,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 32
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: SQRT '[' Exp . ']' '{' Exp '}'
+	    24,  25,  26,   0,  42,  27,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 33
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: SQRT '{' Exp . '}'
+	    24,  25,  26,   0,   0,  27,   0,   0,  43,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 34
+	//   Exp: "(" Exp ")" .
+	   -10, -10, -10,   0, -10, -10,   0,   0, -10,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -10,   0, -10,
+	// 35
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp '*' Exp .
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	    -1,  -1,  -1,   0,  -1,  27,   0,   0,  -1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -1,   0,  -1,
+	// 36
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp '+' Exp .
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	    24,  -2,  -2,   0,  -2,  27,   0,   0,  -2,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -2,   0,  -2,
+	// 37
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp '-' Exp .
+	//   Exp: Exp . '^' '{' Exp '}'
+	    24,  -4,  -4,   0,  -4,  27,   0,   0,  -4,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -4,   0,  -4,
+	// 38
+	//   Exp: Exp '^' '{' . Exp '}'
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  44,   0,
+	// 39
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: PROD '_' '{' Exp . '}' '^' '{' Exp '}' Exp
+	    24,  25,  26,   0,   0,  27,   0,   0,  45,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 40
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: SUM '_' '{' Exp . '}' '^' '{' Exp '}' Exp
+	    24,  25,  26,   0,   0,  27,   0,   0,  46,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 41
+	//   Exp: FRAC '{' Exp '}' . '{' Exp '}'
+	     0,   0,   0,   0,   0,   0,   0,  47,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 42
+	//   Exp: SQRT '[' Exp ']' . '{' Exp '}'
+	     0,   0,   0,   0,   0,   0,   0,  48,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 43
+	//   Exp: SQRT '{' Exp '}' .
+	    -8,  -8,  -8,   0,  -8,  -8,   0,   0,  -8,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -8,   0,  -8,
+	// 44
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: Exp '^' '{' Exp . '}'
+	    24,  25,  26,   0,   0,  27,   0,   0,  49,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 45
+	//   Exp: PROD '_' '{' Exp '}' . '^' '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,  50,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 46
+	//   Exp: SUM '_' '{' Exp '}' . '^' '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,  51,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 47
+	//   Exp: FRAC '{' Exp '}' '{' . Exp '}'
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  52,   0,
+	// 48
+	//   Exp: SQRT '[' Exp ']' '{' . Exp '}'
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  53,   0,
+	// 49
+	//   Exp: Exp '^' '{' Exp '}' .
+	    -7,  -7,  -7,   0,  -7,  -7,   0,   0,  -7,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -7,   0,  -7,
+	// 50
+	//   Exp: PROD '_' '{' Exp '}' '^' . '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,   0,   0,  54,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 51
+	//   Exp: SUM '_' '{' Exp '}' '^' . '{' Exp '}' Exp
+	     0,   0,   0,   0,   0,   0,   0,  55,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 52
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: FRAC '{' Exp '}' '{' Exp . '}'
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	    24,  25,  26,   0,   0,  27,   0,   0,  56,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 53
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: SQRT '[' Exp ']' '{' Exp . '}'
+	    24,  25,  26,   0,   0,  27,   0,   0,  57,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 54
+	//   Exp: PROD '_' '{' Exp '}' '^' '{' . Exp '}' Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  58,   0,
+	// 55
+	//   Exp: SUM '_' '{' Exp '}' '^' '{' . Exp '}' Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  59,   0,
+	// 56
+	//   Exp: FRAC '{' Exp '}' '{' Exp '}' .
+	    -3,  -3,  -3,   0,  -3,  -3,   0,   0,  -3,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -3,   0,  -3,
+	// 57
+	//   Exp: SQRT '[' Exp ']' '{' Exp '}' .
+	    -9,  -9,  -9,   0,  -9,  -9,   0,   0,  -9,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  -9,   0,  -9,
+	// 58
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: PROD '_' '{' Exp '}' '^' '{' Exp . '}' Exp
+	    24,  25,  26,   0,   0,  27,   0,   0,  60,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 59
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: SUM '_' '{' Exp '}' '^' '{' Exp . '}' Exp
+	    24,  25,  26,   0,   0,  27,   0,   0,  61,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	// 60
+	//   Exp: PROD '_' '{' Exp '}' '^' '{' Exp '}' . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  62,   0,
+	// 61
+	//   Exp: SUM '_' '{' Exp '}' '^' '{' Exp '}' . Exp
+	     0,   0,   1,   0,   0,   0,   0,   0,   0,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,   0,  63,   0,
+	// 62
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: PROD '_' '{' Exp '}' '^' '{' Exp '}' Exp .
+	    24, -12, -12,   0, -12,  27,   0,   0, -12,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -12,   0, -12,
+	// 63
+	//   Exp: Exp . '*' Exp
+	//   Exp: Exp . '+' Exp
+	//   Exp: Exp . '-' Exp
+	//   Exp: Exp . '^' '{' Exp '}'
+	//   Exp: SUM '_' '{' Exp '}' '^' '{' Exp '}' Exp .
+	    24, -11, -11,   0, -11,  27,   0,   0, -11,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, -11,   0, -11
+};
 
-// Таблица состояний. Если число положительное то происходит свдиг (shift) и переход в состояние, соответствующее этому числу.
-// Если число отрицательное, то делаем свертку (reduce) по правилу, соотвествующему этому числу. Если встретили Err, то синтаксическая ошибка.
-
-vector<vector<int> > ParsingTable = { /*        *,    +,    -,    [,    ],    ^,    _,    {,    }, PROD,  SUM,  COT,  TAN,  COS,  SIN,   ID, FRAC, SQRT,    (,    ),  Exp,  EOF */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   12,  Err },  /* 0 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   13,  Err },  /* 1 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,   14,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 2 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,   15,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 3 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   16,  Err },  /* 4 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   17,  Err },  /* 5 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   18,  Err },  /* 6 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   19,  Err },  /* 7 состояние */
-											{  -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6 },  /* 8 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   20,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 9 состояние */
-											{ Err,  Err,  Err,   22,  Err,  Err,  Err,   21,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 10 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   23,  Err },  /* 11 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,   24 },  /* 12 состояние */
-											{  -5,   -5,   -5,   -5,   -5,   28,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5,   -5 },  /* 13 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   29,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 14 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   30,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 15 состояние */
-											{  27,  -16,  -16,  -16,  -16,   28,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16,  -16 },  /* 16 состояние */
-											{  27,  -15,  -15,  -15,  -15,   28,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15 },  /* 17 состояние */
-											{  27,  -14,  -14,  -14,  -14,   28,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14,  -14 },  /* 18 состояние */
-											{  27,  -13,  -13,  -13,  -13,   28,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13,  -13 },  /* 19 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   31,  Err },  /* 20 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   32,  Err },  /* 21 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   33,  Err },  /* 22 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,   34,  Err,  Err },  /* 23 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 24 состояние (не существует) */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   35,  Err },  /* 25 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   36,  Err },  /* 26 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   37,  Err },  /* 27 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   38,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 28 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   39,  Err },  /* 29 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   40,  Err },  /* 30 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   41,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 31 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   42,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 32 состояние */
-											{  27,   25,   26,  Err,   43,   28,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 33 состояние */
-											{ -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10 },  /* 34 состояние */
-											{  27,   -2,   -2,   -2,   -2,   28,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2,   -2 },  /* 35 состояние */
-											{  27,   -4,   -4,   -4,   -4,   28,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4,   -4 },  /* 36 состояние */
-											{  -1,   -1,   -1,   -1,   -1,   28,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1 },  /* 37 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   44,  Err },  /* 38 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   45,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 39 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   46,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 40 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   47,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 41 состояние */
-											{  -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8,   -8 },  /* 42 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   48,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 43 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   49,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 44 состояние */
-											{ Err,  Err,  Err,  Err,  Err,   50,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 45 состояние */
-											{ Err,  Err,  Err,  Err,  Err,   51,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 46 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   52,  Err },  /* 47 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   53,  Err },  /* 48 состояние */
-											{  -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7,   -7 },  /* 49 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   54,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 50 состояние */
-											{ Err,  Err,  Err,  Err,  Err,  Err,  Err,   55,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 51 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   56,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 52 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   57,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 53 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   58,  Err },  /* 54 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   59,  Err },  /* 55 состояние */
-											{  -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3,   -3 },  /* 56 состояние */
-											{  -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9 },  /* 57 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   60,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 58 состояние */
-											{  27,   25,   26,  Err,  Err,   28,  Err,  Err,   61,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err,  Err },  /* 59 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   62,  Err },  /* 60 состояние */
-											{ Err,  Err,    1,  Err,  Err,  Err,  Err,  Err,  Err,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,  Err,   63,  Err },  /* 61 состояние */
-											{  27,  -12,  -12,  -12,  -12,   28,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12,  -12 },  /* 62 состояние */
-											{  27,  -11,  -11,  -11,  -11,   28,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11,  -11 }   /* 62 состояние */
-};
\ No newline at end of file
+const unsigned char ParsingRuleLength[ParsingRulesCount + 1] = {
+	2, // 0 $accept: Exp $end
+	3, // 1 Exp: Exp '*' Exp
+	3, // 2 Exp: Exp '+' Exp
+	7, // 3 Exp: FRAC '{' Exp '}' '{' Exp '}'
+	3, // 4 Exp: Exp '-' Exp
+	2, // 5 Exp: '-' Exp
+	1, // 6 Exp: ID
+	5, // 7 Exp: Exp '^' '{' Exp '}'
+	4, // 8 Exp: SQRT '{' Exp '}'
+	7, // 9 Exp: SQRT '[' Exp ']' '{' Exp '}'
+	3, // 10 Exp: "(" Exp ")"
+	10, // 11 Exp: SUM '_' '{' Exp '}' '^' '{' Exp '}' Exp
+	10, // 12 Exp: PROD '_' '{' Exp '}' '^' '{' Exp '}' Exp
+	2, // 13 Exp: SIN Exp
+	2, // 14 Exp: COS Exp
+	2, // 15 Exp: TAN Exp
+	2 // 16 Exp: COT Exp
+};
@@ -0,0 +1,20 @@
+﻿// Файл сгенерирован скриптом GenerateParsingTable.py по грамматике parser.y. Не редактируйте его вручную:
+// измените parser.y и пересоберите проект (или запустите скрипт)
+
+#pragma once
+
+// Таблица переходов LR-парсера: ParsingTable[состояние * ParsingTableWidth + токен].
+// Положительное число - сдвиг (shift) и переход в состояние с этим номером, отрицательное - свертка (reduce)
+// по правилу с этим номером, ParsingError - синтаксическая ошибка. Столбцы соответствуют TTokenType,
+// нетерминал - столбец TT_NONTERMINAL
+
+const int ParsingTableWidth = 22;
+const int ParsingTableHeight = 64;
+const int ParsingError = 0;
+
+extern const signed char ParsingTable[ParsingTableHeight * ParsingTableWidth];
+
+// Длины правых частей правил. Правило 0 - $accept: Exp $end
+const int ParsingRulesCount = 16;
+
+extern const unsigned char ParsingRuleLength[ParsingRulesCount + 1];
@@ -1,71 +1,90 @@
-#define MATHTRANSLATORDLL_EXPORTS
+﻿#define MATHTRANSLATORDLL_EXPORTS
 
 #include "TranslatorDLLInterface.h"
 #include <string>
 #include <assert.h> 
+#include <string.h>
 #include "MathML.h"
 #include "MathFormObj.h"
 #include "ConvertOM.h"
 #include <memory>
 #include <fstream>  
 #include "ConvertLatex.h"
+#include "BatchConverter.h"
 
-void ConvertFormula( std::string inputFileName, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string outputFileName ) 
+// Разбирает формулу в компактное дерево. Latex разбирается прямо из input,
+// а для XML нужна строка с завершающим нулем, поэтому она копируется
+static void readFormula( const char* input, size_t inputLength, TSupportedFormats inputFormat, CMathTree& tree )
 {
-		shared_ptr<FormulaObj> obj(new FormulaObj(NT_MAIN));
-		MathMLParser mmlparser;
-		CConvertLatex latexConverter;
-		shared_ptr<MathObj> latexObj;
-
 		if (inputFormat == SF_OPENMATH) {
-			ConvertFromOM(inputFileName, obj);
+			shared_ptr<FormulaObj> obj(new FormulaObj(NT_MAIN));
+			ConvertFromOMString(std::string(input, inputLength), obj);
+			tree.Assign(obj);
 		}
 		if (inputFormat == SF_MATHML) {
-			mmlparser.Pars(inputFileName);
+			MathMLParser mmlparser;
+			mmlparser.ParsString(std::string(input, inputLength));
+			tree.Assign(mmlparser.GetData());
 		}
-
 		if (inputFormat == SF_LATEX) {
-			ifstream ifs(inputFileName);
-			string str((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
-			latexObj = latexConverter.ConvertFromLatex(str);
-			ifs.close();
+			CConvertLatex latexConverter;
+			latexConverter.ConvertFromLatex(input, static_cast<int>(inputLength), tree);
 		}
-		if (outputFormat == SF_OPENMATH) {
-			if (inputFormat == SF_OPENMATH) {
-				ConvertToOM(outputFileName, obj);
-			}
-			if (inputFormat == SF_MATHML) {
-				ConvertToOM(outputFileName, mmlparser.GetData());
-			}
+}
 
-			if (inputFormat == SF_LATEX) {
-				ConvertToOM(outputFileName, latexObj);
-			}
+// Записывает дерево формулы в строку нужного формата
+static void writeFormula( const CMathTree& tree, TSupportedFormats outputFormat, std::string& output )
+{
+		if (outputFormat == SF_OPENMATH) {
+			ConvertToOMString(tree, output);
 		}
 		if (outputFormat == SF_MATHML) {
-			if (inputFormat == SF_OPENMATH) {
-				mmlparser.SetData(obj);
-				mmlparser.Save(outputFileName);
-			}
-			if (inputFormat == SF_MATHML)
-				mmlparser.Save(outputFileName);
-
-			if (inputFormat == SF_LATEX) {
-				mmlparser.SetData(latexObj);
-				mmlparser.Save(outputFileName);
-			}
+			MathMLParser::SaveToString(tree, output);
 		}
 		if (outputFormat == SF_LATEX) {
-			string outStr;
-			if (inputFormat == SF_LATEX) {
-				latexConverter.ConvertToLatex(latexObj, outStr);
-			} else if (inputFormat == SF_OPENMATH) {
-				latexConverter.ConvertToLatex(obj, outStr);
-			} else if (inputFormat == SF_MATHML) {
-				latexConverter.ConvertToLatex(mmlparser.GetData(), outStr);
-			}
-			ofstream ofs(outputFileName, ios::out);
-			ofs << outStr;
-			ofs.close();
+			CConvertLatex latexConverter;
+			latexConverter.ConvertToLatex(tree, output);
 		}
-}
\ No newline at end of file
+}
+
+void ConvertFormulaText( const std::string& input, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string& output )
+{
+		ConvertFormulaText(input.data(), input.length(), inputFormat, outputFormat, output);
+}
+
+void ConvertFormulaText( const char* input, size_t inputLength, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string& output )
+{
+		CMathTree tree;
+		readFormula(input, inputLength, inputFormat, tree);
+		output.clear();
+		writeFormula(tree, outputFormat, output);
+}
+
+size_t ConvertFormulaText( const char* input, size_t inputLength, TSupportedFormats inputFormat, TSupportedFormats outputFormat, char* outputBuffer, size_t bufferSize )
+{
+		std::string output;
+		ConvertFormulaText(input, inputLength, inputFormat, outputFormat, output);
+		if (output.size() < bufferSize) {
+			memcpy(outputBuffer, output.c_str(), output.size() + 1);
+		}
+		return output.size();
+}
+
+void ConvertFormula( std::string inputFileName, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string outputFileName ) 
+{
+		ifstream ifs(inputFileName);
+		string input((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+		ifs.close();
+
+		string output;
+		ConvertFormulaText(input, inputFormat, outputFormat, output);
+
+		ofstream ofs(outputFileName, ios::out);
+		ofs << output;
+		ofs.close();
+}
+
+int ConvertFormulaBatch( std::string input, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string output, std::ostream& report, int threadsCount )
+{
+		return ConvertBatch(input, inputFormat, outputFormat, output, report, threadsCount);
+}
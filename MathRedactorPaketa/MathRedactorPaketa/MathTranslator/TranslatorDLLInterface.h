@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <ostream>
 #include <string>
 
 // Поддерживаемые форматы конвентора.
@@ -15,4 +16,19 @@ enum TSupportedFormats {
 #define MATHTRANSLATORDLL_API __declspec(dllimport) 
 #endif
 
+// Конвертирует формулу из файла inputFile в файл outputFile
 void MATHTRANSLATORDLL_API ConvertFormula( std::string inputFile, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string outputFile );
+
+// Конвертирует формулу из памяти в строку, без обращения к файлам.
+// При ошибке разбора Latex бросает std::invalid_argument
+void MATHTRANSLATORDLL_API ConvertFormulaText( const std::string& input, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string& output );
+void MATHTRANSLATORDLL_API ConvertFormulaText( const char* input, size_t inputLength, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string& output );
+// То же, но результат пишется в буфер вызывающего вместе с завершающим нулем, если он туда помещается.
+// Возвращает длину результата без завершающего нуля, так что при нехватке места можно повторить вызов с буфером нужного размера
+size_t MATHTRANSLATORDLL_API ConvertFormulaText( const char* input, size_t inputLength, TSupportedFormats inputFormat, TSupportedFormats outputFormat, char* outputBuffer, size_t bufferSize );
+
+// Пакетная конвертация: input - файл с формулами по одной на строку или папка с файлами формул,
+// результаты пишутся в порядке входа в файл или папку output. Формулы конвертируются на threadsCount потоках
+// (0 - по числу ядер). Ошибки отдельных формул и скорость по форматам печатаются в report и не прерывают пакет.
+// Возвращает число формул, которые не удалось сконвертировать, или -1, если не удалось прочитать вход или записать результат
+int MATHTRANSLATORDLL_API ConvertFormulaBatch( std::string input, TSupportedFormats inputFormat, TSupportedFormats outputFormat, std::string output, std::ostream& report, int threadsCount = 0 );
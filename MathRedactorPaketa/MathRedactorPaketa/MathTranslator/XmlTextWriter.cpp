@@ -0,0 +1,117 @@
+﻿// Описание: Реализация записи XML в строку
+
+#include "XmlTextWriter.h"
+#include "tinyxml.h"
+#include <assert.h>
+#include <string.h>
+
+using namespace std;
+
+CXmlTextWriter::CXmlTextWriter( string& _output, bool _singleLine ) :
+	output( _output ),
+	singleLine( _singleLine ),
+	isStartTagOpen( false ),
+	hasText( false )
+{
+}
+
+void CXmlTextWriter::WriteDeclaration()
+{
+	indent();
+	output += "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>";
+	lineBreak();
+}
+
+void CXmlTextWriter::OpenElement( const char* name )
+{
+	assert( !hasText );
+	closeStartTag();
+	indent();
+	output += '<';
+	output += name;
+	elements.push_back( name );
+	isStartTagOpen = true;
+}
+
+void CXmlTextWriter::AddAttribute( const char* name, const char* value )
+{
+	assert( isStartTagOpen );
+	// Как TiXmlAttribute::Print: значение с двойной кавычкой берется в одинарные
+	char quote = strchr( value, '"' ) == 0 ? '"' : '\'';
+	output += ' ';
+	writeEncoded( name );
+	output += '=';
+	output += quote;
+	writeEncoded( value );
+	output += quote;
+}
+
+void CXmlTextWriter::AddText( const char* text )
+{
+	assert( isStartTagOpen );
+	output += '>';
+	isStartTagOpen = false;
+	hasText = true;
+	writeEncoded( text );
+}
+
+void CXmlTextWriter::CloseElement()
+{
+	assert( !elements.empty() );
+	const char* name = elements.back();
+	elements.pop_back();
+
+	if( isStartTagOpen ) {
+		output += " />";
+		isStartTagOpen = false;
+	} else {
+		if( hasText ) {
+			hasText = false;
+		} else {
+			indent();
+		}
+		output += "</";
+		output += name;
+		output += '>';
+	}
+	lineBreak();
+}
+
+void CXmlTextWriter::WriteTextElement( const char* name, const char* text )
+{
+	OpenElement( name );
+	AddText( text );
+	CloseElement();
+}
+
+void CXmlTextWriter::closeStartTag()
+{
+	if( isStartTagOpen ) {
+		output += '>';
+		isStartTagOpen = false;
+		lineBreak();
+	}
+}
+
+void CXmlTextWriter::indent()
+{
+	if( !singleLine ) {
+		int depth = static_cast<int>( elements.size() );
+		output.append( 4 * ( depth < MaxIndentDepth ? depth : MaxIndentDepth ), ' ' );
+	}
+}
+
+void CXmlTextWriter::lineBreak()
+{
+	if( !singleLine ) {
+		output += '\n';
+	}
+}
+
+void CXmlTextWriter::writeEncoded( const char* text )
+{
+	// Экранирование то же, что при печати DOM TinyXML
+	TIXML_STRING encoded;
+	TiXmlBase::EncodeString( TIXML_STRING( text ), &encoded );
+	output.append( encoded.c_str(), encoded.length() );
+}
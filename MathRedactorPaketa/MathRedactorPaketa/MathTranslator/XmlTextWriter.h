@@ -0,0 +1,43 @@
+﻿// Описание: Запись XML прямо в строку, без построения DOM TinyXML. DOM TinyXML печатается и удаляется рекурсивно,
+// по вызову на уровень вложенности, поэтому глубокие формулы переполняли стек. Здесь вложенность хранится в векторе.
+// Формат совпадает с TiXmlPrinter: отступ в четыре пробела на уровень, элемент с единственным текстом - в одну строку.
+// Отступ растет только до MaxIndentDepth уровней, иначе размер текста был бы квадратичным по глубине формулы
+// Чтение MathML и OpenMath по-прежнему идет через DOM TinyXML, так что глубина читаемых формул ограничена стеком
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+class CXmlTextWriter {
+public:
+	// singleLine - без отступов и переносов строк, как TiXmlPrinter::SetStreamPrinting
+	CXmlTextWriter( std::string& output, bool singleLine );
+
+	// <?xml version="1.0" encoding="UTF-8" ?>
+	void WriteDeclaration();
+
+	// Открыть элемент. Атрибуты добавляются сразу после открытия, до потомков
+	void OpenElement( const char* name );
+	void AddAttribute( const char* name, const char* value );
+	// Единственный текст элемента. После него элемент можно только закрыть
+	void AddText( const char* text );
+	void CloseElement();
+
+	// Элемент с единственным текстом: <name>text</name>
+	void WriteTextElement( const char* name, const char* text );
+
+	static const int MaxIndentDepth = 64;
+
+private:
+	std::string& output;
+	bool singleLine;
+	std::vector<const char*> elements; // Открытые элементы
+	bool isStartTagOpen; // У последнего открытого элемента еще не записан '>'
+	bool hasText; // У последнего открытого элемента есть текст
+
+	void closeStartTag();
+	void indent();
+	void lineBreak();
+	void writeEncoded( const char* text );
+};
@@ -49,8 +49,8 @@ Exp:
 	| SQRT '{' Exp '}'
 	| SQRT '[' Exp ']' '{' Exp '}'
 	| "(" Exp ")"
-	| SUM '_' '{' Exp '}' '^' '{' Exp '}' Exp
-	| PROD '_' '{' Exp '}' '^' '{' Exp '}' Exp
+	| SUM '_' '{' Exp '}' '^' '{' Exp '}' Exp %prec SUM
+	| PROD '_' '{' Exp '}' '^' '{' Exp '}' Exp %prec PROD
 	| SIN Exp
 	| COS Exp
 	| TAN Exp
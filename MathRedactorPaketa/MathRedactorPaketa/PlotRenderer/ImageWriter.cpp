@@ -0,0 +1,124 @@
+﻿#include "ImageWriter.h"
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+	// Таблица для вычисления CRC-32 блоков PNG
+	struct CCrcTable {
+		unsigned int Values[256];
+		CCrcTable()
+		{
+			for( unsigned int i = 0; i < 256; i++ ) {
+				unsigned int value = i;
+				for( int bit = 0; bit < 8; bit++ ) {
+					value = ( value & 1 ) ? 0xEDB88320u ^ ( value >> 1 ) : value >> 1;
+				}
+				Values[i] = value;
+			}
+		}
+	};
+
+	unsigned int Crc32( const std::string& data )
+	{
+		static const CCrcTable table;
+		unsigned int crc = 0xFFFFFFFFu;
+		for( size_t i = 0; i < data.size(); i++ ) {
+			crc = table.Values[( crc ^ static_cast<unsigned char>( data[i] ) ) & 0xFF] ^ ( crc >> 8 );
+		}
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	void AppendBigEndian( std::string& data, unsigned int value )
+	{
+		data.push_back( static_cast<char>( value >> 24 ) );
+		data.push_back( static_cast<char>( value >> 16 ) );
+		data.push_back( static_cast<char>( value >> 8 ) );
+		data.push_back( static_cast<char>( value ) );
+	}
+
+	// Записывает блок PNG: длина, тип, данные, контрольная сумма типа и данных
+	void WriteChunk( std::ofstream& file, const char* type, const std::string& data )
+	{
+		std::string chunk( type );
+		chunk += data;
+		std::string length;
+		AppendBigEndian( length, static_cast<unsigned int>( data.size() ) );
+		std::string crc;
+		AppendBigEndian( crc, Crc32( chunk ) );
+		file << length << chunk << crc;
+	}
+
+}
+
+namespace ImageWriter
+{
+	bool WritePPM( const std::string& path, const std::vector<unsigned int>& pixels, int width, int height )
+	{
+		std::ofstream file( path.c_str(), std::ios::out | std::ios::binary );
+		file << "P6\n" << width << " " << height << "\n255\n";
+		std::string row( width * 3, 0 );
+		for( int y = 0; y < height; y++ ) {
+			for( int x = 0; x < width; x++ ) {
+				const unsigned int pixel = pixels[y * width + x];
+				row[x * 3] = static_cast<char>( pixel & 0xFF );
+				row[x * 3 + 1] = static_cast<char>( ( pixel >> 8 ) & 0xFF );
+				row[x * 3 + 2] = static_cast<char>( ( pixel >> 16 ) & 0xFF );
+			}
+			file.write( row.data(), row.size() );
+		}
+		return file.good();
+	}
+
+	bool WritePNG( const std::string& path, const std::vector<unsigned int>& pixels, int width, int height )
+	{
+		std::ofstream file( path.c_str(), std::ios::out | std::ios::binary );
+		file << "\x89PNG\r\n\x1A\n";
+
+		// Заголовок: размеры, 8 бит на канал, RGB
+		std::string header;
+		AppendBigEndian( header, width );
+		AppendBigEndian( header, height );
+		header += std::string( "\x08\x02\x00\x00\x00", 5 );
+		WriteChunk( file, "IHDR", header );
+
+		// Строки изображения, каждая с фильтром 0 (без фильтрации)
+		std::string raw;
+		raw.reserve( ( width * 3 + 1 ) * height );
+		for( int y = 0; y < height; y++ ) {
+			raw.push_back( 0 );
+			for( int x = 0; x < width; x++ ) {
+				const unsigned int pixel = pixels[y * width + x];
+				raw.push_back( static_cast<char>( pixel & 0xFF ) );
+				raw.push_back( static_cast<char>( ( pixel >> 8 ) & 0xFF ) );
+				raw.push_back( static_cast<char>( ( pixel >> 16 ) & 0xFF ) );
+			}
+		}
+
+		// Поток zlib из несжатых блоков deflate (не более 65535 байт каждый) и контрольной суммы Adler-32
+		std::string data( "\x78\x01", 2 );
+		const size_t maxBlockSize = 65535;
+		for( size_t offset = 0; offset < raw.size() || offset == 0; offset += maxBlockSize ) {
+			const size_t size = std::min( maxBlockSize, raw.size() - offset );
+			const bool last = offset + size >= raw.size();
+			data.push_back( last ? 1 : 0 );
+			data.push_back( static_cast<char>( size & 0xFF ) );
+			data.push_back( static_cast<char>( size >> 8 ) );
+			data.push_back( static_cast<char>( ~size & 0xFF ) );
+			data.push_back( static_cast<char>( ( ~size >> 8 ) & 0xFF ) );
+			data.append( raw, offset, size );
+			if( last ) {
+				break;
+			}
+		}
+		unsigned int a = 1, b = 0;
+		for( size_t i = 0; i < raw.size(); i++ ) {
+			a = ( a + static_cast<unsigned char>( raw[i] ) ) % 65521;
+			b = ( b + a ) % 65521;
+		}
+		AppendBigEndian( data, ( b << 16 ) | a );
+		WriteChunk( file, "IDAT", data );
+		WriteChunk( file, "IEND", std::string() );
+		return file.good();
+	}
+}
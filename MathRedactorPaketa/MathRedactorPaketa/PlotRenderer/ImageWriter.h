@@ -0,0 +1,13 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+// Запись изображений в формате CSoftwareRasterizer (пиксели построчно, байты R, G, B, A) в файлы
+namespace ImageWriter
+{
+	// Записывает изображение в бинарный PPM (P6). Возвращает false при ошибке записи
+	bool WritePPM( const std::string& path, const std::vector<unsigned int>& pixels, int width, int height );
+
+	// Записывает изображение в PNG (RGB, без сжатия, чтобы не зависеть от zlib). Возвращает false при ошибке записи
+	bool WritePNG( const std::string& path, const std::vector<unsigned int>& pixels, int width, int height );
+}
@@ -0,0 +1,340 @@
+﻿// Описание: консольная утилита для пакетного построения графиков без окна.
+// Читает файл заданий (по формуле на строку), строит каждый график программным растеризатором
+// и сохраняет его в PPM или PNG (и, по желанию, сетку графика в .mesh, OBJ, STL или PLY). Задания распределяются по потокам.
+//
+// Формат строки задания:  <формула> | <min1> <max1> [<min2> <max2>] | <eps>
+// например:  z = sin(x) * cos(y) | -10 10 -10 10 | 0.1
+// Пустые строки и строки, начинающиеся с '#', пропускаются.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EngineCamera.h"
+#include "evaluate.h"
+#include "FormulaParser.h"
+#include "SoftwareRasterizer.h"
+#include "ImageWriter.h"
+#include "MeshExchange.h"
+#include "MeshFile.h"
+
+namespace {
+
+	// Одно задание: формула и диапазоны её параметров
+	struct CPlotJob {
+		int Line;
+		std::string Formula;
+		double Min[2], Max[2];
+		int RangesCount;
+		double Eps;
+	};
+
+	// Результат обработки задания
+	struct CPlotResult {
+		bool Success;
+		std::string Error;
+		int Points;
+		int Segments;
+	};
+
+	// Параметры запуска
+	struct CSettings {
+		std::string JobsFile;
+		std::string OutputDirectory;
+		std::string Camera;
+		std::string Format;
+		int Width, Height;
+		int ThreadsCount;
+		// Сохранять ли сетку каждого графика рядом с изображением
+		bool SaveMesh;
+		// Формат экспорта сетки каждого графика (obj, stl, ply) или пустая строка
+		std::string ExportFormat;
+
+		CSettings() : OutputDirectory( "." ), Camera( "iso" ), Format( "png" ), Width( 800 ), Height( 600 ), ThreadsCount( 0 ),
+			SaveMesh( false ) {}
+	};
+
+	// Длина осей координат (как в CWinPlotter)
+	const int AxisLength = 20;
+
+	void PrintUsage()
+	{
+		std::cerr << "Usage: PlotRenderer <jobs file> [--camera front|side|top|iso] [--size WIDTHxHEIGHT]" << std::endl
+			<< "                    [--format png|ppm] [--out DIRECTORY] [--threads N] [--mesh]" << std::endl
+			<< "                    [--export obj|stl|ply]" << std::endl
+			<< "Jobs file line: <formula> | <min1> <max1> [<min2> <max2>] | <eps>" << std::endl;
+	}
+
+	bool ParseArguments( int argc, char* argv[], CSettings& settings )
+	{
+		for( int i = 1; i < argc; i++ ) {
+			const std::string argument = argv[i];
+			if( argument[0] != '-' ) {
+				settings.JobsFile = argument;
+				continue;
+			}
+			if( argument == "--mesh" ) {
+				settings.SaveMesh = true;
+				continue;
+			}
+			if( i + 1 >= argc ) {
+				return false;
+			}
+			const std::string value = argv[++i];
+			if( argument == "--camera" ) {
+				settings.Camera = value;
+			} else if( argument == "--size" ) {
+				char separator = 0;
+				std::istringstream stream( value );
+				if( !( stream >> settings.Width >> separator >> settings.Height ) || separator != 'x' ) {
+					return false;
+				}
+			} else if( argument == "--format" ) {
+				settings.Format = value;
+			} else if( argument == "--out" ) {
+				settings.OutputDirectory = value;
+			} else if( argument == "--threads" ) {
+				settings.ThreadsCount = std::atoi( value.c_str() );
+			} else if( argument == "--export" ) {
+				settings.ExportFormat = value;
+			} else {
+				return false;
+			}
+		}
+		return !settings.JobsFile.empty() && ( settings.Format == "png" || settings.Format == "ppm" ) &&
+			( settings.ExportFormat.empty() || CMeshExchange::IsSupported( "." + settings.ExportFormat ) ) &&
+			( settings.Camera == "front" || settings.Camera == "side" || settings.Camera == "top" || settings.Camera == "iso" );
+	}
+
+	// Читает задания из файла. Некорректные строки сразу попадают в список ошибок
+	std::vector<CPlotJob> ReadJobs( std::istream& input, std::vector<std::string>& errors )
+	{
+		std::vector<CPlotJob> jobs;
+		std::string line;
+		for( int lineNumber = 1; std::getline( input, line ); lineNumber++ ) {
+			const size_t first = line.find_first_not_of( " \t\r" );
+			if( first == std::string::npos || line[first] == '#' ) {
+				continue;
+			}
+			const size_t rangesBegin = line.find( '|' );
+			const size_t epsBegin = rangesBegin == std::string::npos ? std::string::npos : line.find( '|', rangesBegin + 1 );
+			CPlotJob job;
+			job.Line = lineNumber;
+			job.RangesCount = 0;
+			bool correct = epsBegin != std::string::npos;
+			if( correct ) {
+				job.Formula = line.substr( 0, rangesBegin );
+				std::istringstream ranges( line.substr( rangesBegin + 1, epsBegin - rangesBegin - 1 ) );
+				while( job.RangesCount < 2 && ranges >> job.Min[job.RangesCount] >> job.Max[job.RangesCount] ) {
+					job.RangesCount++;
+				}
+				std::istringstream eps( line.substr( epsBegin + 1 ) );
+				correct = job.RangesCount > 0 && ( eps >> job.Eps ) && job.Eps > 0;
+			}
+			if( correct ) {
+				jobs.push_back( job );
+			} else {
+				std::ostringstream error;
+				error << "line " << lineNumber << ": malformed job";
+				errors.push_back( error.str() );
+			}
+		}
+		return jobs;
+	}
+
+	// Устанавливает камеру в одно из стандартных положений
+	void SetCameraPreset( CEngineCamera& engine, const std::string& camera )
+	{
+		engine.Reset();
+		if( camera == "side" ) {
+			engine.RotateSideAroundCenter( std::atan( 1.0 ) * 2 );
+		} else if( camera == "top" ) {
+			// Не ровно 90 градусов, чтобы направление взгляда не совпало с вертикальным вектором камеры
+			engine.RotateUpAroundCenter( -1.5 );
+		} else if( camera == "iso" ) {
+			engine.RotateSideAroundCenter( std::atan( 1.0 ) );
+			engine.RotateUpAroundCenter( -0.6 );
+		}
+	}
+
+	// Строит, отрисовывает и сохраняет один график. Все буферы принадлежат потоку и переиспользуются
+	class CPlotWorker {
+	public:
+		CPlotWorker( const CSettings& settings ) :
+			settings( settings ), engine( settings.Width, settings.Height ), rasterizer( settings.Width, settings.Height, 1 )
+		{
+			// Параллельность уже по заданиям, поэтому движок и растеризатор каждого потока работают в одном потоке
+			engine.SetThreadsCount( 1 );
+			engine.SetWindowSize( settings.Width, settings.Height );
+			SetCameraPreset( engine, settings.Camera );
+
+			axisObject.AddPoint( C3DPoint( AxisLength, 0, 0 ) );
+			axisObject.AddPoint( C3DPoint( -AxisLength, 0, 0 ) );
+			axisObject.AddSegment( 0, 1 );
+			axisObject.AddPoint( C3DPoint( 0, AxisLength, 0 ) );
+			axisObject.AddPoint( C3DPoint( 0, -AxisLength, 0 ) );
+			axisObject.AddSegment( 2, 3 );
+			axisObject.AddPoint( C3DPoint( 0, 0, AxisLength ) );
+			axisObject.AddPoint( C3DPoint( 0, 0, -AxisLength ) );
+			axisObject.AddSegment( 4, 5 );
+		}
+
+		CPlotResult Process( const CPlotJob& job )
+		{
+			CPlotResult result = { false, std::string(), 0, 0 };
+			try {
+				const CFormula formula = ParseFormula( job.Formula );
+				const std::vector<char> variables = formula.GetVariables();
+				if( static_cast<int>( variables.size() ) > job.RangesCount ) {
+					result.Error = "not enough parameter ranges";
+					return result;
+				}
+				std::map< char, std::pair< double, double > > args;
+				for( int i = 0; i < static_cast<int>( variables.size() ); i++ ) {
+					args[variables[i]] = std::make_pair( job.Min[i], job.Max[i] );
+				}
+				if( !builder.buildPointGrid( formula, args, job.Eps ) ) {
+					result.Error = "formula builder error";
+					return result;
+				}
+
+				plotObject.Clear();
+				plotObject.Points = builder.GetPoints();
+				const std::vector< std::pair< int, int > >& segments = builder.GetSegments();
+				for( int i = 0; i < static_cast<int>( segments.size() ); i++ ) {
+					plotObject.AddSegment( segments[i].first, segments[i].second );
+				}
+
+				rasterizer.Clear( CSoftwareRasterizer::MakeColor( 0, 0, 0 ) );
+				engine.Render( axisObject, renderedObject );
+				rasterizer.Draw( renderedObject, engine.GetDepths(), CSoftwareRasterizer::MakeColor( 41, 128, 185 ), 0 );
+				engine.Render( plotObject, renderedObject );
+				rasterizer.Draw( renderedObject, engine.GetDepths(), CSoftwareRasterizer::MakeColor( 0, 255, 0 ),
+					CSoftwareRasterizer::MakeColor( 0, 96, 0 ) );
+
+				std::ostringstream path;
+				path << settings.OutputDirectory << "/plot_" << job.Line << "." << settings.Format;
+				const bool written = settings.Format == "png" ?
+					ImageWriter::WritePNG( path.str(), rasterizer.GetPixels(), settings.Width, settings.Height ) :
+					ImageWriter::WritePPM( path.str(), rasterizer.GetPixels(), settings.Width, settings.Height );
+				if( !written ) {
+					result.Error = "cannot write " + path.str();
+					return result;
+				}
+				if( settings.SaveMesh ) {
+					std::ostringstream meshPath;
+					meshPath << settings.OutputDirectory << "/plot_" << job.Line << ".mesh";
+					try {
+						CMeshFile::Save( plotObject, meshPath.str() );
+					} catch( CMeshFile::CannotOpen& ) {
+						result.Error = "cannot write " + meshPath.str();
+						return result;
+					}
+				}
+				if( !settings.ExportFormat.empty() ) {
+					std::ostringstream exportPath;
+					exportPath << settings.OutputDirectory << "/plot_" << job.Line << "." << settings.ExportFormat;
+					try {
+						CMeshExchange::Write( plotObject, exportPath.str() );
+					} catch( CMeshExchange::CannotOpen& ) {
+						result.Error = "cannot write " + exportPath.str();
+						return result;
+					}
+				}
+				result.Success = true;
+				result.Points = static_cast<int>( plotObject.Points.size() );
+				result.Segments = static_cast<int>( plotObject.Segments.size() );
+			} catch( std::exception& exception ) {
+				result.Error = exception.what();
+			} catch( ... ) {
+				result.Error = "invalid formula";
+			}
+			return result;
+		}
+
+	private:
+		const CSettings& settings;
+		CGraphBuilder builder;
+		CEngineCamera engine;
+		CSoftwareRasterizer rasterizer;
+		C3DModel axisObject;
+		C3DModel plotObject;
+		C2DModel renderedObject;
+	};
+
+}
+
+int main( int argc, char* argv[] )
+{
+	CSettings settings;
+	if( !ParseArguments( argc, argv, settings ) ) {
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+	std::ifstream input( settings.JobsFile.c_str() );
+	if( !input ) {
+		std::cerr << "Cannot open " << settings.JobsFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::string> errors;
+	const std::vector<CPlotJob> jobs = ReadJobs( input, errors );
+	std::vector<CPlotResult> results( jobs.size() );
+
+	const auto start = std::chrono::steady_clock::now();
+
+	// Потоки разбирают задания по очереди, каждый со своими движком и растеризатором
+	int threadsCount = settings.ThreadsCount > 0 ? settings.ThreadsCount :
+		std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) );
+	threadsCount = std::max( 1, std::min( threadsCount, static_cast<int>( jobs.size() ) ) );
+	std::atomic<int> nextJob( 0 );
+	auto work = [&]() {
+		CPlotWorker worker( settings );
+		for( int i = nextJob++; i < static_cast<int>( jobs.size() ); i = nextJob++ ) {
+			results[i] = worker.Process( jobs[i] );
+		}
+	};
+	std::vector<std::thread> threads;
+	for( int i = 1; i < threadsCount; i++ ) {
+		threads.push_back( std::thread( work ) );
+	}
+	work();
+	for( auto thread = threads.begin(); thread != threads.end(); thread++ ) {
+		thread->join();
+	}
+
+	const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+	// Итоги: ошибки в порядке строк файла и производительность
+	int succeeded = 0;
+	long long points = 0, segments = 0;
+	for( int i = 0; i < static_cast<int>( jobs.size() ); i++ ) {
+		if( results[i].Success ) {
+			succeeded++;
+			points += results[i].Points;
+			segments += results[i].Segments;
+		} else {
+			std::ostringstream error;
+			error << "line " << jobs[i].Line << ": " << results[i].Error;
+			errors.push_back( error.str() );
+		}
+	}
+	for( auto error = errors.begin(); error != errors.end(); error++ ) {
+		std::cerr << *error << std::endl;
+	}
+	std::cout << succeeded << " plots rendered, " << errors.size() << " failed, " << threadsCount << " threads" << std::endl
+		<< seconds << " s, " << ( seconds > 0 ? succeeded / seconds : 0 ) << " plots/s, "
+		<< ( seconds > 0 ? points / seconds / 1e6 : 0 ) << " Mpoints/s, "
+		<< ( seconds > 0 ? segments / seconds / 1e6 : 0 ) << " Msegments/s" << std::endl;
+
+	return errors.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -13,6 +13,8 @@ description:
 #include "Messages.h"
 #include "Utils.h"
 #include "CWinMain.h"
+#include "MeshExchange.h"
+#include "MeshFile.h"
 #include <Windows.h>
 #include "resource.h"
 #include <assert.h>
@@ -329,10 +331,98 @@ void CWinMain::buildPlot()
 		for( int j = 0; j < static_cast< int >( segmentsIds.size() ); j++ ) {
 			winPlotter.testObject.AddSegment( segmentsIds[j].first, segmentsIds[j].second );
 		}
-		winPlotter.moveX( 0 );
+
+		// Прореженные сетки для отрисовки графика издалека
+		winPlotter.testObjectLevels.resize( builder.GetLevelsCount() - 1 );
+		for( int level = 1; level < builder.GetLevelsCount(); level++ ) {
+			C3DModel& levelObject = winPlotter.testObjectLevels[level - 1];
+			const std::vector< C3DPoint >& levelPoints = builder.GetLevelPoints( level );
+			const std::vector< std::pair< int, int > >& levelSegmentsIds = builder.GetLevelSegments( level );
+
+			levelObject.Clear();
+			for( int j = 0; j < static_cast< int >( levelPoints.size() ); j++ ) {
+				levelObject.AddPoint( levelPoints[j] );
+			}
+			for( int j = 0; j < static_cast< int >( levelSegmentsIds.size() ); j++ ) {
+				levelObject.AddSegment( levelSegmentsIds[j].first, levelSegmentsIds[j].second );
+			}
+		}
+		winPlotter.updateObject();
+	}
+}
+
+// Запрашивает имя файла сетки (.mesh, .obj, .stl, .ply) в стандартном диалоге открытия или сохранения
+static bool askMeshFileName( HWND owner, bool save, std::string& fileName )
+{
+	char buffer[MAX_PATH] = "plot.mesh";
+	OPENFILENAMEA dialog;
+	::ZeroMemory( &dialog, sizeof( dialog ) );
+	dialog.lStructSize = sizeof( dialog );
+	dialog.hwndOwner = owner;
+	dialog.lpstrFilter = "Mesh (*.mesh)\0*.mesh\0Wavefront OBJ (*.obj)\0*.obj\0Binary STL (*.stl)\0*.stl\0"
+		"Binary PLY (*.ply)\0*.ply\0";
+	dialog.lpstrFile = buffer;
+	dialog.nMaxFile = MAX_PATH;
+	dialog.lpstrDefExt = "mesh";
+	dialog.Flags = save ? OFN_OVERWRITEPROMPT : OFN_FILEMUSTEXIST;
+	if( !( save ? ::GetSaveFileNameA( &dialog ) : ::GetOpenFileNameA( &dialog ) ) ) {
+		return false;
+	}
+	fileName = buffer;
+	return true;
+}
+
+void CWinMain::SavePlot()
+{
+	std::string fileName;
+	if( !askMeshFileName( handle, true, fileName ) ) {
+		return;
+	}
+	try {
+		if( CMeshExchange::IsSupported( fileName ) ) {
+			CMeshExchange::Write( winPlotter.testObject, fileName );
+		} else {
+			CMeshFile::Save( winPlotter.testObject, fileName );
+		}
+	} catch( CMeshFile::CannotOpen& ) {
+		::MessageBox( handle, L"Не удалось сохранить график", L"Error", MB_OK | MB_ICONERROR );
+	} catch( CMeshExchange::CannotOpen& ) {
+		::MessageBox( handle, L"Не удалось сохранить график", L"Error", MB_OK | MB_ICONERROR );
 	}
 }
 
+void CWinMain::OpenPlot()
+{
+	std::string fileName;
+	if( !askMeshFileName( handle, false, fileName ) ) {
+		return;
+	}
+	try {
+		if( CMeshExchange::IsSupported( fileName ) ) {
+			CMeshExchange::Read( fileName, winPlotter.testObject );
+		} else {
+			CMeshFile meshFile;
+			meshFile.Open( fileName );
+			meshFile.CopyTo( winPlotter.testObject );
+		}
+	} catch( CMeshFile::CannotOpen& ) {
+		::MessageBox( handle, L"Не удалось открыть файл", L"Error", MB_OK | MB_ICONERROR );
+		return;
+	} catch( CMeshExchange::CannotOpen& ) {
+		::MessageBox( handle, L"Не удалось открыть файл", L"Error", MB_OK | MB_ICONERROR );
+		return;
+	} catch( CMeshFile::BadFormat& ) {
+		::MessageBox( handle, L"Неверный формат файла", L"Error", MB_OK | MB_ICONERROR );
+		return;
+	} catch( CMeshExchange::BadFormat& ) {
+		::MessageBox( handle, L"Неверный формат файла", L"Error", MB_OK | MB_ICONERROR );
+		return;
+	}
+	// Уровни детализации строятся только для графиков формул
+	winPlotter.testObjectLevels.clear();
+	winPlotter.updateObject();
+}
+
 LRESULT CWinMain::OnKeyDown( WPARAM wParam, LPARAM lParam )
 {
 	switch( wParam ) {
@@ -351,6 +441,15 @@ LRESULT CWinMain::OnKeyDown( WPARAM wParam, LPARAM lParam )
 		case VK_SPACE:
 			winPlotter.reset();
 			return 0;
+		case VK_F2:
+			SavePlot();
+			return 0;
+		case VK_F3:
+			winPlotter.toggleStatistics();
+			return 0;
+		case VK_F4:
+			OpenPlot();
+			return 0;
 		default:
 			return DefWindowProc( handle, WM_KEYDOWN, wParam, lParam );
 	}
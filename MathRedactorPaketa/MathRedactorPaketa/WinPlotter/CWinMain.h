@@ -39,6 +39,8 @@ protected:
 	void TakeFormula();									// принять формулу
 	LRESULT OnKeyDown( WPARAM wParam, LPARAM lParam );	// обработка нажатия клавиш (стрелки для перемещения по графику)
 	LRESULT OnKeyUp( WPARAM wParam, LPARAM lParam );	// обработка отжатия клавиш
+	void SavePlot();									// сохранить график в файл сетки, OBJ, STL или PLY (F2)
+	void OpenPlot();									// открыть график из файла сетки, OBJ, STL или PLY (F4)
 
 private:
 	enum TDirection { D_None, D_Top, D_Bot, D_Right, D_Left };
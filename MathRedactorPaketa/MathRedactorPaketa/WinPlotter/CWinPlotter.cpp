@@ -4,6 +4,7 @@
 #include <fstream>
 
 #include "3DPoint.h"
+#include "MeshFile.h"
 
 
 LRESULT __stdcall CWinPlotter::windowProc( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam )
@@ -57,6 +58,25 @@ void CWinPlotter::show(int cmdShow)
 	::ShowWindow( handle, cmdShow );
 }
 
+void CWinPlotter::loadTestObjectText()
+{
+	testObject.Clear();
+	std::ifstream testText( "PAKETA.txt", std::ifstream::in );
+	int points, segments;
+	const double coef = 2;
+	testText >> points >> segments;
+	for( int i = 0; i < points; i++ ) {
+		double x, z;
+		testText >> x >> z;
+		testObject.AddPoint( C3DPoint( ( x - 4.25 ) * coef, 0, ( z + 0.1 ) * coef ) );
+	}
+	for( int i = 0; i < segments; i++ ) {
+		int first, second;
+		testText >> first >> second;
+		testObject.AddSegment( first, second );
+	}
+}
+
 void CWinPlotter::OnDestroy()
 {
 	::PostQuitMessage( 0 );
@@ -76,21 +96,17 @@ void CWinPlotter::UpdateScreenSize()
 
 void CWinPlotter::OnCreate()
 {
-	// Создаём тестовый объект - РАКЕТА
-	std::ifstream testText( "PAKETA.txt", std::ifstream::in );
-	int points, segments;
-	const double coef = 2;
-	testText >> points >> segments;
-	for( int i = 0; i < points; i++ ) {
-		double x, z;
-		testText >> x >> z;
-		testObject.AddPoint( C3DPoint( ( x - 4.25 ) * coef, 0, ( z + 0.1 ) * coef ) );
-	}
-	for( int i = 0; i < segments; i++ ) {
-		int first, second;
-		testText >> first >> second;
-		testObject.AddSegment( first, second );
+	// Создаём тестовый объект - РАКЕТА. Сохранённая сетка открывается без разбора текста, иначе читаем исходный файл
+	try {
+		CMeshFile meshFile;
+		meshFile.Open( "PAKETA.mesh" );
+		meshFile.CopyTo( testObject );
+	} catch( CMeshFile::CannotOpen& ) {
+		loadTestObjectText();
+	} catch( CMeshFile::BadFormat& ) {
+		loadTestObjectText();
 	}
+	buildObjectLevels();
 
 	// Создаём оси
 	axisObject.AddPoint( C3DPoint( axisLength, 0, 0 ) );
@@ -104,6 +120,10 @@ void CWinPlotter::OnCreate()
 	axisObject.AddPoint( C3DPoint( 0, 0, axisLength ) );
 	axisObject.AddPoint( C3DPoint( 0, 0, -axisLength ) );
 	axisObject.AddSegment( 4, 5 );
+
+	// Объекты рисуются в порядке добавления: оси поверх графика
+	scene.AddObject( testObjectLOD, RGB( 0, 255, 0 ) );
+	scene.AddObject( axisObject, RGB( 41, 128, 185 ) );
 }
 
 void CWinPlotter::PaintObject()
@@ -111,10 +131,18 @@ void CWinPlotter::PaintObject()
 	// Передаём размеры окна
 	UpdateScreenSize();
 
-	// Делаем рендер объекта
-	engine.Render( testObject, renderedObject );
-	// Делаем рендер осей
-	engine.Render( axisObject, axisRenderedObject, false );
+	// Делаем рендер сцены, если с прошлой отрисовки изменились камера или объект. Перерисовка окна
+	// без движения камеры (например, после перекрытия другим окном) обходится без движка.
+	// Оси обрезаются по области видимости, а не отбрасываются целиком
+	const unsigned int cameraVersion = engine.GetVersion();
+	paintStatistics.Cached = true;
+	if( cameraVersion != renderedCameraVersion || testObjectVersion != renderedObjectVersion ) {
+		engine.Render( scene, renderedScene );
+		renderedCameraVersion = cameraVersion;
+		renderedObjectVersion = testObjectVersion;
+		paintStatistics.Cached = false;
+		paintStatistics.Engine = engine.GetStatistics();
+	}
 
 
 	RECT rect;
@@ -129,72 +157,121 @@ void CWinPlotter::PaintObject()
 	PatBlt( currentDC, 0, 0, rect.right - rect.left, rect.bottom - rect.top, BLACKNESS );
 
 
-	HPEN linePen = ::CreatePen( PS_SOLID, 1, RGB( 0, 255, 0 ) );
-	HPEN currentPen = ( HPEN )::SelectObject( currentDC, linePen );
-
-	HBRUSH pointBrush = ::CreateSolidBrush( RGB( 0, 255, 0 ) );
-	HBRUSH currentBrush = ( HBRUSH )::SelectObject( currentDC, pointBrush );
-	// Вершины
-	/* может потом и потребуется их рисовать, но сейчас они лишь мешают
-	for( auto point = renderedObject.Points.begin(); point != renderedObject.Points.end(); point++ ) {
-		Ellipse( currentDC, static_cast< int >( point->X - 1 ), static_cast< int >( point->Y - 1 ),
-			static_cast< int >( point->X + 1 ), static_cast< int >( point->Y + 1 ) );
-	}
-	*/
-
-	// Отрезки
-	for( auto segment = renderedObject.Segments.begin(); segment != renderedObject.Segments.end(); segment++ ) {
-		MoveToEx( currentDC,
-			static_cast< int >( renderedObject.Points[segment->First].X ),
-			static_cast< int >( renderedObject.Points[segment->First].Y ),
-			0 );
-		LineTo( currentDC,
-			static_cast< int >( renderedObject.Points[segment->Second].X ),
-			static_cast< int >( renderedObject.Points[segment->Second].Y ) );
-	}
-	// Треугольники
-	for( auto triangle = renderedObject.Triangles.begin(); triangle != renderedObject.Triangles.end(); triangle++ ) {
-		MoveToEx( currentDC,
-			static_cast< int >( renderedObject.Points[triangle->First].X ),
-			static_cast< int >( renderedObject.Points[triangle->First].Y ),
-			0 );
-		LineTo( currentDC,
-			static_cast< int >( renderedObject.Points[triangle->Second].X ),
-			static_cast< int >( renderedObject.Points[triangle->Second].Y ) );
-		LineTo( currentDC,
-			static_cast< int >( renderedObject.Points[triangle->Third].X ),
-			static_cast< int >( renderedObject.Points[triangle->Third].Y ) );
-		LineTo( currentDC,
-			static_cast< int >( renderedObject.Points[triangle->First].X ),
-			static_cast< int >( renderedObject.Points[triangle->First].Y ) );
+	const double drawStartTime = showStatistics ? CStopwatch::Now() : 0;
+	const C2DModel& renderedObject = renderedScene.Model;
+	HPEN currentPen = 0;
+	for( auto sceneObject = renderedScene.Objects.begin(); sceneObject != renderedScene.Objects.end(); sceneObject++ ) {
+		// Кисть объекта
+		HPEN linePen = ::CreatePen( PS_SOLID, 1, sceneObject->Color );
+		HPEN previousPen = ( HPEN )::SelectObject( currentDC, linePen );
+		if( currentPen == 0 ) {
+			currentPen = previousPen;
+		} else {
+			::DeleteObject( previousPen );
+		}
+
+		// Отрезки
+		for( int i = sceneObject->SegmentsBegin; i < sceneObject->SegmentsEnd; i++ ) {
+			const CSegmentIndex& segment = renderedObject.Segments[i];
+			MoveToEx( currentDC,
+				static_cast< int >( renderedObject.Points[segment.First].X ),
+				static_cast< int >( renderedObject.Points[segment.First].Y ),
+				0 );
+			LineTo( currentDC,
+				static_cast< int >( renderedObject.Points[segment.Second].X ),
+				static_cast< int >( renderedObject.Points[segment.Second].Y ) );
+		}
+		// Треугольники
+		for( int i = sceneObject->TrianglesBegin; i < sceneObject->TrianglesEnd; i++ ) {
+			const CTriangleIndex& triangle = renderedObject.Triangles[i];
+			MoveToEx( currentDC,
+				static_cast< int >( renderedObject.Points[triangle.First].X ),
+				static_cast< int >( renderedObject.Points[triangle.First].Y ),
+				0 );
+			LineTo( currentDC,
+				static_cast< int >( renderedObject.Points[triangle.Second].X ),
+				static_cast< int >( renderedObject.Points[triangle.Second].Y ) );
+			LineTo( currentDC,
+				static_cast< int >( renderedObject.Points[triangle.Third].X ),
+				static_cast< int >( renderedObject.Points[triangle.Third].Y ) );
+			LineTo( currentDC,
+				static_cast< int >( renderedObject.Points[triangle.First].X ),
+				static_cast< int >( renderedObject.Points[triangle.First].Y ) );
+		}
 	}
 
-	// Кисть для осей координат
-	HPEN axisPen = ::CreatePen( PS_SOLID, 1, RGB( 41, 128, 185 ) );
-	currentPen = ( HPEN )::SelectObject( currentDC, axisPen );
-	for( auto segment = axisRenderedObject.Segments.begin(); segment != axisRenderedObject.Segments.end(); segment++ ) {
-		MoveToEx( currentDC,
-			static_cast< int >( axisRenderedObject.Points[segment->First].X ),
-			static_cast< int >( axisRenderedObject.Points[segment->First].Y ),
-			0 );
-		LineTo( currentDC,
-			static_cast< int >( axisRenderedObject.Points[segment->Second].X ),
-			static_cast< int >( axisRenderedObject.Points[segment->Second].Y ) );
+	// Возвращаем исходную кисть, последняя созданная удаляется
+	if( currentPen != 0 ) {
+		::DeleteObject( ::SelectObject( currentDC, currentPen ) );
 	}
 
-	::DeleteObject( pointBrush );
-	::DeleteObject( currentBrush );
-
-	::DeleteObject( linePen );
-	::DeleteObject( axisPen );
+	if( showStatistics ) {
+		paintStatistics.DrawTime = CStopwatch::Now() - drawStartTime;
+		paintStatistics.DrawnSegments = 0;
+		paintStatistics.DrawnTriangles = 0;
+		for( auto sceneObject = renderedScene.Objects.begin(); sceneObject != renderedScene.Objects.end(); sceneObject++ ) {
+			paintStatistics.DrawnSegments += sceneObject->SegmentsEnd - sceneObject->SegmentsBegin;
+			paintStatistics.DrawnTriangles += sceneObject->TrianglesEnd - sceneObject->TrianglesBegin;
+		}
+		PaintStatistics( currentDC );
+	}
 
-	::SelectObject( currentDC, currentPen );
 	::DeleteObject( currentBitmap );
 	DeleteDC( currentDC );
 
 	EndPaint( handle, &paintStruct );
 }
 
+void CWinPlotter::PaintStatistics( HDC dc )
+{
+	const CRenderStatistics& engineStatistics = paintStatistics.Engine;
+	wchar_t lines[4][128];
+	swprintf_s( lines[0], L"engine: %.2f ms (transform %.2f, filter %.2f, merge %.2f)%s",
+		engineStatistics.RenderTime, engineStatistics.TransformTime, engineStatistics.FilterTime,
+		engineStatistics.MergeTime, paintStatistics.Cached ? L", cached" : L"" );
+	swprintf_s( lines[1], L"points: %d in, %d projected, %d culled",
+		engineStatistics.InputPoints, engineStatistics.ProjectedPoints, engineStatistics.CulledPoints );
+	swprintf_s( lines[2], L"segments: %d in, %d merged; triangles: %d in",
+		engineStatistics.InputSegments, engineStatistics.MergedSegments, engineStatistics.InputTriangles );
+	swprintf_s( lines[3], L"draw: %.2f ms, %d segments, %d triangles",
+		paintStatistics.DrawTime, paintStatistics.DrawnSegments, paintStatistics.DrawnTriangles );
+
+	const int previousMode = ::SetBkMode( dc, TRANSPARENT );
+	const COLORREF previousColor = ::SetTextColor( dc, RGB( 255, 255, 255 ) );
+	TEXTMETRIC textMetric;
+	::GetTextMetrics( dc, &textMetric );
+	for( int i = 0; i < 4; i++ ) {
+		::TextOut( dc, 4, 4 + i * textMetric.tmHeight, lines[i], static_cast<int>( wcslen( lines[i] ) ) );
+	}
+	::SetTextColor( dc, previousColor );
+	::SetBkMode( dc, previousMode );
+}
+
+void CWinPlotter::toggleStatistics()
+{
+	showStatistics = !showStatistics;
+	engine.EnableStatistics( showStatistics );
+	// Пересчитываем проекции, чтобы сразу показать статистику движка
+	renderedObjectVersion = 0;
+	Invalidate();
+}
+
+void CWinPlotter::updateObject()
+{
+	buildObjectLevels();
+	testObjectVersion++;
+	Invalidate();
+}
+
+void CWinPlotter::buildObjectLevels()
+{
+	testObjectLOD.Clear();
+	testObjectLOD.AddLevel( testObject );
+	for( auto level = testObjectLevels.begin(); level != testObjectLevels.end(); level++ ) {
+		testObjectLOD.AddLevel( *level );
+	}
+}
+
 void CWinPlotter::Invalidate()
 {
 	RECT rect;
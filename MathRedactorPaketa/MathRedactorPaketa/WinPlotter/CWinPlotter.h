@@ -2,11 +2,30 @@
 #include "Windows.h"
 #include "EngineCamera.h"
 #include "Model.h"
+#include "ModelLOD.h"
+#include "Scene.h"
+
+// Статистика последней перерисовки окна плоттера
+struct CPaintStatistics {
+	// Статистика движка для последнего пересчёта проекций
+	CRenderStatistics Engine;
+	// Были ли проекции при перерисовке взяты готовыми (движок не вызывался)
+	bool Cached;
+	// Время вывода примитивов через GDI в миллисекундах и число выведенных отрезков и треугольников
+	double DrawTime;
+	int DrawnSegments;
+	int DrawnTriangles;
+};
 
 class CWinPlotter {
 public:
 	// Трёхмерный примитив, который будет рисоваться на экране
 	C3DModel testObject;
+	// Прореженные копии testObject для отрисовки издалека (уровни детализации 1, 2, ...), могут отсутствовать
+	std::vector< C3DModel > testObjectLevels;
+	// Сообщает плоттеру об изменении testObject и testObjectLevels (перестраивает уровни детализации
+	// и перерисовывает окно)
+	void updateObject();
 
 	static bool registerClass( HINSTANCE hInstance );
 	HWND create( HINSTANCE hInctance, HWND parent );
@@ -19,6 +38,11 @@ public:
 	void zoom( LONG times = 1 );
 	void reset();
 
+	// Включает/выключает сбор статистики отрисовки и её вывод поверх графика
+	void toggleStatistics();
+	// Статистика последней перерисовки (собирается, пока включён её вывод)
+	const CPaintStatistics& getStatistics() const { return paintStatistics; }
+
 protected:
 	void OnCreate();
 	void OnDestroy();
@@ -47,10 +71,31 @@ private:
 	// Длина отрисовки осей в каждое из направлений
 	const int axisLength = 20;
 
-	// Структура двухмерного объекта, который будет непосредственно переводиться в вызовы WinAPI
-	C2DModel renderedObject;
-	// Аналог для объекта с осями
-	C2DModel axisRenderedObject;
+	// Уровни детализации testObject вместе с иерархиями ограничивающих объёмов, по которым движок отсекает
+	// невидимые части
+	CModelLOD testObjectLOD;
+	// Перестраивает testObjectLOD по testObject и testObjectLevels
+	void buildObjectLevels();
+	// Читает testObject из текстового файла PAKETA.txt
+	void loadTestObjectText();
+
+	// Сцена из осей и testObject, которая отрисовывается движком за один проход
+	CScene scene;
+	// Двухмерные примитивы сцены, которые будут непосредственно переводиться в вызовы WinAPI
+	CRenderedScene renderedScene;
+
+	// Версия testObject, увеличивается при каждом вызове updateObject
+	unsigned int testObjectVersion = 1;
+	// Версии камеры и объекта, для которых был получен renderedScene. Пока они совпадают с текущими,
+	// проекции берутся готовыми и движок при перерисовке не вызывается
+	unsigned int renderedCameraVersion = 0;
+	unsigned int renderedObjectVersion = 0;
+
+	// Выводится ли статистика отрисовки поверх графика
+	bool showStatistics = false;
+	CPaintStatistics paintStatistics;
+	// Выводит статистику в левый верхний угол окна
+	void PaintStatistics( HDC dc );
 
 	static LRESULT __stdcall windowProc( HWND handle, UINT message, WPARAM wParam, LPARAM lParam );
 };
\ No newline at end of file
@@ -1,14 +1,19 @@
 ﻿#include "EngineCamera.h"
 #include <cmath>
-#include <set>
+#include <algorithm>
+#include <thread>
 
 // Ближняя и дальная плоскости отсечения (координаты по Z)
 const double CEngineCamera::NearZ = 1;
 const double CEngineCamera::FarZ = 100;
 
 CEngineCamera::CEngineCamera( int clientWidth, int clientHeight ) :
-ViewDistance( 1 ), ClientHeight( clientHeight ), ClientWidth( clientWidth ), stepSize( 1 )
+version( 0 ), stepSize( 1 ), ViewDistance( 1 ), ClientWidth( clientWidth ), ClientHeight( clientHeight ), threadsCount( 1 ), hasCulledPoints( false ),
+	levelOfDetailThreshold( 1 ), segmentMergeThreshold( 0.5 ), pointsBase( 0 ), statisticsEnabled( false ), renderStartTime( 0 )
 {
+	SetThreadsCount( 0 );
+	// Параметры проекции должны соответствовать размерам, иначе кэш по версии камеры не заметит их первой установки
+	SetWindowSize( clientWidth, clientHeight );
 	// устанваливаем движок в начальное положение 
 	Reset();
 }
@@ -43,34 +48,257 @@ void CEngineCamera::UpdateUpVector()
 
 void CEngineCamera::UpdateTransformMatrix()
 {
-	TransformMatrix.Set( 0, 0, RightVector.X );
-	TransformMatrix.Set( 0, 1, UpVector.X );
-	TransformMatrix.Set( 0, 2, ViewDirection.X );
-	TransformMatrix.Set( 0, 3, 0 );
+	TransformMatrix = CMat4::View( CVec3( Position ), CVec3( RightVector ), CVec3( UpVector ), CVec3( ViewDirection ) );
 
-	TransformMatrix.Set( 1, 0, RightVector.Y );
-	TransformMatrix.Set( 1, 1, UpVector.Y );
-	TransformMatrix.Set( 1, 2, ViewDirection.Y );
-	TransformMatrix.Set( 1, 3, 0 );
-
-	TransformMatrix.Set( 2, 0, RightVector.Z );
-	TransformMatrix.Set( 2, 1, UpVector.Z );
-	TransformMatrix.Set( 2, 2, ViewDirection.Z );
-	TransformMatrix.Set( 2, 3, 0 );
-
-	TransformMatrix.Set( 3, 0, -Position.dot( RightVector ) );
-	TransformMatrix.Set( 3, 1, -Position.dot( UpVector ) );
-	TransformMatrix.Set( 3, 2, -Position.dot( ViewDirection ) );
-	TransformMatrix.Set( 3, 3, 1 );
+	version++;
 }
 
 void CEngineCamera::Render( const C3DModel& object, C2DModel& renderedObject, bool filtrate )
 {
-	transform( object );
+	beginStatistics();
+	countInput( object );
+	pointsBase = 0;
+	transformAndProject( object, renderedObject, filtrate );
 	if( filtrate == true ) {
-		filter();
+		filter( object, renderedObject );
+		renderedObject.Segments.erase( renderedObject.Segments.begin() +
+			mergeShortSegments( renderedObject, 0, static_cast<int>( renderedObject.Segments.size() ) ),
+			renderedObject.Segments.end() );
+	}
+	endStatistics( renderedObject );
+}
+
+void CEngineCamera::Render( const C3DModel& object, const CModelBVH& hierarchy, C2DModel& renderedObject )
+{
+	if( hierarchy.GetModelPointsCount() != static_cast<int>( object.Points.size() ) ) {
+		throw CEngineCamera::OutdatedHierarchy();
+	}
+
+	beginStatistics();
+	countInput( object );
+	updateClipPlanes();
+	pointsBase = 0;
+	pointOutcodes.resize( object.Points.size() );
+	renderedObject.Points.resize( object.Points.size() );
+	renderedDepths.resize( object.Points.size() );
+	renderedObject.Segments.clear();
+	renderedObject.Triangles.clear();
+	renderHierarchy( object, hierarchy, renderedObject );
+	renderedObject.Segments.erase( renderedObject.Segments.begin() +
+		mergeShortSegments( renderedObject, 0, static_cast<int>( renderedObject.Segments.size() ) ),
+		renderedObject.Segments.end() );
+	endStatistics( renderedObject );
+}
+
+void CEngineCamera::Render( const CScene& scene, CRenderedScene& renderedScene )
+{
+	beginStatistics();
+
+	// Выбираем модели объектов и проверяем иерархии заранее, чтобы не оставить результат отрисованным наполовину
+	int pointsCount = 0;
+	sceneModels.assign( scene.GetObjectsCount(), std::pair<const C3DModel*, const CModelBVH*>( 0, 0 ) );
+	for( int i = 0; i < scene.GetObjectsCount(); i++ ) {
+		const CSceneObject& sceneObject = scene.GetObjectAt( i );
+		if( !sceneObject.Visible ) {
+			continue;
+		}
+		if( sceneObject.Levels != 0 ) {
+			if( sceneObject.Levels->GetLevelsCount() == 0 ) {
+				continue;
+			}
+			const int level = SelectLevel( *sceneObject.Levels );
+			sceneModels[i].first = &sceneObject.Levels->GetModel( level );
+			sceneModels[i].second = &sceneObject.Levels->GetHierarchy( level );
+		} else {
+			sceneModels[i].first = sceneObject.Model;
+			sceneModels[i].second = sceneObject.Hierarchy;
+		}
+		if( sceneModels[i].second != 0 &&
+			sceneModels[i].second->GetModelPointsCount() != static_cast<int>( sceneModels[i].first->Points.size() ) )
+		{
+			throw CEngineCamera::OutdatedHierarchy();
+		}
+		pointsCount += static_cast<int>( sceneModels[i].first->Points.size() );
+	}
+
+	// Матрица и плоскости отсечения общие для всех объектов. Точки объектов занимают начало выходной модели,
+	// вершины, появившиеся при отсечении, дописываются после них
+	updateClipPlanes();
+	C2DModel& renderedObject = renderedScene.Model;
+	pointOutcodes.resize( pointsCount );
+	renderedObject.Points.resize( pointsCount );
+	renderedDepths.resize( pointsCount );
+	renderedObject.Segments.clear();
+	renderedObject.Triangles.clear();
+	renderedScene.Objects.clear();
+
+	pointsBase = 0;
+	for( int i = 0; i < scene.GetObjectsCount(); i++ ) {
+		if( sceneModels[i].first == 0 ) {
+			continue;
+		}
+		const CSceneObject& sceneObject = scene.GetObjectAt( i );
+		const C3DModel& object = *sceneModels[i].first;
+		countInput( object );
+
+		CRenderedSceneObject renderedSceneObject;
+		renderedSceneObject.Index = i;
+		renderedSceneObject.Color = sceneObject.Color;
+		renderedSceneObject.SegmentsBegin = static_cast<int>( renderedObject.Segments.size() );
+		renderedSceneObject.TrianglesBegin = static_cast<int>( renderedObject.Triangles.size() );
+		if( sceneModels[i].second != 0 ) {
+			renderHierarchy( object, *sceneModels[i].second, renderedObject );
+		} else {
+			hasCulledPoints = false;
+			projectPoints( object, 0, static_cast<int>( object.Points.size() ), renderedObject, true );
+			addFiltered( object, renderedObject );
+		}
+		renderedSceneObject.SegmentsEnd = mergeShortSegments( renderedObject, renderedSceneObject.SegmentsBegin,
+			static_cast<int>( renderedObject.Segments.size() ) );
+		renderedObject.Segments.erase( renderedObject.Segments.begin() + renderedSceneObject.SegmentsEnd,
+			renderedObject.Segments.end() );
+		renderedSceneObject.TrianglesEnd = static_cast<int>( renderedObject.Triangles.size() );
+		renderedScene.Objects.push_back( renderedSceneObject );
+
+		pointsBase += static_cast<int>( object.Points.size() );
+	}
+	pointsBase = 0;
+	endStatistics( renderedObject );
+}
+
+void CEngineCamera::beginStatistics()
+{
+	if( statisticsEnabled ) {
+		statistics.Reset();
+		renderStartTime = CStopwatch::Now();
+	}
+}
+
+void CEngineCamera::endStatistics( const C2DModel& renderedObject )
+{
+	if( statisticsEnabled ) {
+		statistics.RenderTime = CStopwatch::Now() - renderStartTime;
+		// Всё, что не проецирование и не объединение отрезков, - отсечение
+		statistics.FilterTime = statistics.RenderTime - statistics.TransformTime - statistics.MergeTime;
+		statistics.RenderedSegments = static_cast<int>( renderedObject.Segments.size() );
+		statistics.RenderedTriangles = static_cast<int>( renderedObject.Triangles.size() );
+	}
+}
+
+void CEngineCamera::countInput( const C3DModel& object )
+{
+	if( statisticsEnabled ) {
+		statistics.InputPoints += static_cast<int>( object.Points.size() );
+		statistics.InputSegments += static_cast<int>( object.Segments.size() );
+		statistics.InputTriangles += static_cast<int>( object.Triangles.size() );
+	}
+}
+
+int CEngineCamera::SelectLevel( const CModelLOD& levels ) const
+{
+	// Длину отрезка на экране оцениваем по ближайшей к камере точке модели: ближе всего отрезки видны крупнее всего
+	const std::vector<CModelBVH::CNode>& nodes = levels.GetHierarchy( 0 ).GetNodes();
+	if( nodes.empty() ) {
+		return 0;
+	}
+	double nearestZ = FarZ;
+	for( int i = 0; i < 8; i++ ) {
+		nearestZ = std::min( nearestZ, TransformMatrix.TransformPoint( CVec3( nodes[0].Bounds.Corner( i ) ) ).Z );
+	}
+	if( nearestZ < NearZ ) {
+		// Камера внутри модели или рядом с ней
+		return 0;
+	}
+
+	for( int level = 0; level < levels.GetLevelsCount() - 1; level++ ) {
+		if( levels.GetEdgeLength( level ) * ViewDistance / nearestZ >= levelOfDetailThreshold ) {
+			return level;
+		}
+	}
+	return levels.GetLevelsCount() - 1;
+}
+
+void CEngineCamera::renderHierarchy( const C3DModel& object, const CModelBVH& hierarchy, C2DModel& renderedObject )
+{
+	const std::vector<CModelBVH::CNode>& nodes = hierarchy.GetNodes();
+	hasCulledPoints = false;
+	if( nodes.empty() ) {
+		return;
+	}
+
+	const std::vector<int>& points = hierarchy.GetPoints();
+	const std::vector<CSegmentIndex>& segments = hierarchy.GetSegments();
+	const std::vector<CTriangleIndex>& triangles = hierarchy.GetTriangles();
+
+	// Обходим дерево в глубину, проверяя параллелепипеды узлов по пирамиде видимости
+	nodesStack.clear();
+	nodesStack.push_back( 0 );
+	while( !nodesStack.empty() ) {
+		const CModelBVH::CNode& node = nodes[nodesStack.back()];
+		nodesStack.pop_back();
+
+		unsigned char andCode = 0xFF;
+		unsigned char orCode = 0;
+		for( int i = 0; i < 8; i++ ) {
+			const CVec3 corner = TransformMatrix.TransformPoint( CVec3( node.Bounds.Corner( i ) ) );
+			const unsigned char code = outcode( corner.X, corner.Y, corner.Z );
+			andCode &= code;
+			orCode |= code;
+		}
+
+		if( andCode != 0 ) {
+			// Узел целиком снаружи одной из плоскостей - отбрасываем всё поддерево
+			continue;
+		}
+		if( orCode == 0 ) {
+			// Узел целиком видим - проецируем его точки и переносим элементы без отсечения
+			projectPoints( object, points.data() + node.PointsBegin, node.PointsEnd - node.PointsBegin, renderedObject, false );
+			addSegments( segments.data() + node.SegmentsBegin, node.SegmentsEnd - node.SegmentsBegin, renderedObject );
+			addTriangles( triangles.data() + node.TrianglesBegin, node.TrianglesEnd - node.TrianglesBegin, renderedObject );
+		} else if( !node.IsLeaf() ) {
+			nodesStack.push_back( node.Right );
+			nodesStack.push_back( node.Left );
+		} else {
+			// Лист на границе видимости - отсекаем каждый его элемент
+			projectPoints( object, points.data() + node.PointsBegin, node.PointsEnd - node.PointsBegin, renderedObject, true );
+			for( int i = node.SegmentsBegin; i < node.SegmentsEnd; i++ ) {
+				clipAndAddSegment( object, segments[i], renderedObject );
+			}
+			for( int i = node.TrianglesBegin; i < node.TrianglesEnd; i++ ) {
+				clipAndAddTriangle( object, triangles[i], renderedObject );
+			}
+		}
+	}
+}
+
+void CEngineCamera::updateClipPlanes()
+{
+	// Видимая часть экрана по X и Y, выраженная в координатах x / z и y / z системы камеры
+	const double slopeX = ( 0.5 * ClientWidth - 0.5 ) / ViewDistance;
+	const double slopeY = ( 0.5 * ClientHeight - 0.5 ) / ( ViewDistance * AspectRatio );
+
+	const CClipPlane planes[ClipPlanesCount] = {
+		{ 1, 0, slopeX, 0 },	// левая:  x >= -slopeX * z
+		{ -1, 0, slopeX, 0 },	// правая: x <= slopeX * z
+		{ 0, 1, slopeY, 0 },	// нижняя: y >= -slopeY * z
+		{ 0, -1, slopeY, 0 },	// верхняя: y <= slopeY * z
+		{ 0, 0, 1, -NearZ },	// ближняя: z >= NearZ
+		{ 0, 0, -1, FarZ }		// дальняя: z <= FarZ
+	};
+	for( int i = 0; i < ClipPlanesCount; i++ ) {
+		clipPlanes[i] = planes[i];
 	}
-	render( renderedObject );
+}
+
+unsigned char CEngineCamera::outcode( double x, double y, double z ) const
+{
+	unsigned char code = 0;
+	for( int i = 0; i < ClipPlanesCount; i++ ) {
+		if( clipPlanes[i].Distance( x, y, z ) < 0 ) {
+			code |= 1 << i;
+		}
+	}
+	return code;
 }
 
 void CEngineCamera::SetWindowSize( int clientWidth_, int clientHeight_ )
@@ -78,94 +306,375 @@ void CEngineCamera::SetWindowSize( int clientWidth_, int clientHeight_ )
 	if( clientWidth_ <= 0 || clientHeight_ <= 0 ) {
 		throw CEngineCamera::IncorrectWindowSize();
 	}
+	if( clientWidth_ != ClientWidth || clientHeight_ != ClientHeight ) {
+		version++;
+	}
 	ClientWidth = clientWidth_;
 	ClientHeight = clientHeight_;
 
 	// Расстояние до экрана проекции устанавлиается как половина ширины экрана
 	ViewDistance = ( ClientWidth - 1 ) / 2;
 
-	// Соотношение между шириной и высотой
-	AspectRatio = ClientWidth / ClientHeight;
+	// Соотношение между шириной и высотой. Делим без округления: у окна выше своей ширины целое отношение было бы 0,
+	// и все точки проецировались бы на одну горизонталь, а наклон верхней и нижней плоскостей отсечения стал бы бесконечным
+	AspectRatio = static_cast<double>( ClientWidth ) / ClientHeight;
 }
 
-void CEngineCamera::transform( const C3DModel& object )
+void CEngineCamera::transformAndProject( const C3DModel& object, C2DModel& renderedObject, bool filtrate )
 {
-	// Копируем исходный объект
-	cameraModel = C3DModel( object );
+	const int count = static_cast<int>( object.Points.size() );
+	renderedObject.Points.resize( count );
+	renderedDepths.resize( count );
+
+	hasCulledPoints = false;
+	if( filtrate ) {
+		updateClipPlanes();
+		pointOutcodes.resize( count );
+	} else {
+		// Так как сама структура объекта (отрезки и треугольники) не меняется при проецировании, то мы просто копируем
+		// имеющиеся индексы. Векторы renderedObject переиспользуют свою ёмкость между кадрами
+		renderedObject.Triangles.assign( object.Triangles.begin(), object.Triangles.end() );
+		renderedObject.Segments.assign( object.Segments.begin(), object.Segments.end() );
+	}
 
-	// Пробегаемся по всем его точкам и модифицируем при помощи матрицы преобразований
-	for( auto point = cameraModel.Points.begin(); point != cameraModel.Points.end(); point++ ) {
-		*point = modifyPoint( *point );
+	projectPoints( object, 0, count, renderedObject, filtrate );
+}
+
+void CEngineCamera::SetThreadsCount( int threadsCount_ )
+{
+	threadsCount = threadsCount_ > 0 ? threadsCount_ : std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) );
+}
+
+void CEngineCamera::projectPoints( const C3DModel& object, const int* indices, int count, C2DModel& renderedObject,
+	bool filtrate )
+{
+	const double startTime = statisticsEnabled ? CStopwatch::Now() : 0;
+	int culledCount = 0;
+
+	// Выходные массивы уже имеют нужный размер, а номера точек не повторяются (у узлов иерархии свои списки
+	// точек без повторов), поэтому разные диапазоны пишутся в разные ячейки и делятся между потоками без синхронизации
+	const int workersCount = count >= ParallelProjectionThreshold ? threadsCount : 1;
+	if( workersCount <= 1 ) {
+		culledCount = projectRange( object, indices, 0, count, renderedObject, filtrate );
+	} else {
+		// Диапазоны выравниваются по блокам
+		const int blocksCount = ( count + BlockSize - 1 ) / BlockSize;
+		const int rangeSize = ( blocksCount + workersCount - 1 ) / workersCount * BlockSize;
+		std::vector<int> culledCounts( workersCount, 0 );
+		std::vector<std::thread> workers;
+		for( int i = 1; i < workersCount && i * rangeSize < count; i++ ) {
+			workers.push_back( std::thread( [this, &object, indices, count, rangeSize, &renderedObject, filtrate,
+				&culledCounts, i]()
+			{
+				culledCounts[i] = projectRange( object, indices, i * rangeSize, std::min( count, ( i + 1 ) * rangeSize ),
+					renderedObject, filtrate );
+			} ) );
+		}
+		culledCounts[0] = projectRange( object, indices, 0, std::min( count, rangeSize ), renderedObject, filtrate );
+		for( auto worker = workers.begin(); worker != workers.end(); worker++ ) {
+			worker->join();
+		}
+		for( int i = 0; i < workersCount; i++ ) {
+			culledCount += culledCounts[i];
+		}
+	}
+	hasCulledPoints |= culledCount != 0;
+
+	if( statisticsEnabled ) {
+		statistics.TransformTime += CStopwatch::Now() - startTime;
+		statistics.ProjectedPoints += count;
+		statistics.CulledPoints += culledCount;
+	}
+}
+
+int CEngineCamera::projectRange( const C3DModel& object, const int* indices, int begin, int end, C2DModel& renderedObject,
+	bool filtrate )
+{
+	int culledCount = 0;
+	const double centerX = 0.5 * ClientWidth - 0.5;
+	const double centerY = 0.5 * ClientHeight - 0.5;
+
+	// Точки обрабатываются блоками: блок переводится в систему камеры пакетным умножением на матрицу, а затем,
+	// пока координаты ещё в кэше, отсекается и проецируется на плоскость обзора камеры
+	double x[BlockSize], y[BlockSize], z[BlockSize];
+	int blockIndices[BlockSize];
+	for( int blockBegin = begin; blockBegin < end; blockBegin += BlockSize ) {
+		const int size = std::min( BlockSize, end - blockBegin );
+		for( int i = 0; i < size; i++ ) {
+			blockIndices[i] = indices == 0 ? blockBegin + i : indices[blockBegin + i];
+			const C3DPoint& originPoint = object.Points[blockIndices[i]];
+			x[i] = originPoint.X;
+			y[i] = originPoint.Y;
+			z[i] = originPoint.Z;
+		}
+		TransformMatrix.TransformPoints( x, y, z, x, y, z, size );
+
+		for( int i = 0; i < size; i++ ) {
+			// Запоминаем положение точки относительно области видимости
+			if( filtrate ) {
+				const unsigned char code = outcode( x[i], y[i], z[i] );
+				pointOutcodes[pointsBase + blockIndices[i]] = code;
+				culledCount += code != 0 ? 1 : 0;
+			}
+			// Аксонометрическое преобразование (проекция на плоскость обзора камеры). Для точек вне области видимости
+			// результат не используется: ссылающиеся на них элементы будут отсечены
+			C2DPoint& newPoint = renderedObject.Points[pointsBase + blockIndices[i]];
+			newPoint.X = ViewDistance * x[i] / z[i] + centerX;
+			newPoint.Y = -ViewDistance * y[i] * AspectRatio / z[i] + centerY;
+			renderedDepths[pointsBase + blockIndices[i]] = z[i];
+		}
+	}
+	return culledCount;
+}
+
+void CEngineCamera::filter( const C3DModel& object, C2DModel& renderedObject )
+{
+	// Если все точки видимы, то топология копируется как есть
+	if( !hasCulledPoints ) {
+		renderedObject.Triangles.assign( object.Triangles.begin(), object.Triangles.end() );
+		renderedObject.Segments.assign( object.Segments.begin(), object.Segments.end() );
+		return;
+	}
+
+	renderedObject.Segments.clear();
+	renderedObject.Triangles.clear();
+	addFiltered( object, renderedObject );
+}
+
+void CEngineCamera::addFiltered( const C3DModel& object, C2DModel& renderedObject )
+{
+	if( !hasCulledPoints ) {
+		addSegments( object.Segments.data(), static_cast<int>( object.Segments.size() ), renderedObject );
+		addTriangles( object.Triangles.data(), static_cast<int>( object.Triangles.size() ), renderedObject );
+		return;
+	}
+
+	// Видимые элементы переносятся с сохранением порядка, частично видимые заменяются своей видимой частью
+	for( auto segment = object.Segments.begin(); segment != object.Segments.end(); segment++ ) {
+		clipAndAddSegment( object, *segment, renderedObject );
+	}
+	for( auto triangle = object.Triangles.begin(); triangle != object.Triangles.end(); triangle++ ) {
+		clipAndAddTriangle( object, *triangle, renderedObject );
 	}
 }
 
-void CEngineCamera::filter()
+void CEngineCamera::addSegments( const CSegmentIndex* segments, int count, C2DModel& renderedObject ) const
 {
-	// TODO: удаление (и модификация) элементов внутренней структуры
+	if( pointsBase == 0 ) {
+		renderedObject.Segments.insert( renderedObject.Segments.end(), segments, segments + count );
+		return;
+	}
+	for( int i = 0; i < count; i++ ) {
+		renderedObject.Segments.push_back( CSegmentIndex( segments[i].First + pointsBase, segments[i].Second + pointsBase ) );
+	}
+}
 
-	// В первом приближении мы просто будем удалять те отрезки и треугольники, у которых хотя бы одна вершина попадает
-	// вне области видимости камеры 
-	std::set<int> pointNumbersForErase; // индексы удаляемых точек
-	int counter = 0;
-	for( auto point = cameraModel.Points.begin(); point != cameraModel.Points.end(); point++ ) {
-		// Если точка находится вне области видимости
-		if( point->Z < NearZ || point->Z > FarZ || std::abs( point->X ) > point->Z ) {
-			pointNumbersForErase.insert( counter );
+void CEngineCamera::addTriangles( const CTriangleIndex* triangles, int count, C2DModel& renderedObject ) const
+{
+	if( pointsBase == 0 ) {
+		renderedObject.Triangles.insert( renderedObject.Triangles.end(), triangles, triangles + count );
+		return;
+	}
+	for( int i = 0; i < count; i++ ) {
+		renderedObject.Triangles.push_back( CTriangleIndex( triangles[i].First + pointsBase,
+			triangles[i].Second + pointsBase, triangles[i].Third + pointsBase ) );
+	}
+}
+
+void CEngineCamera::clipAndAddSegment( const C3DModel& object, const CSegmentIndex& segment, C2DModel& renderedObject )
+{
+	const unsigned char firstCode = pointOutcodes[pointsBase + segment.First];
+	const unsigned char secondCode = pointOutcodes[pointsBase + segment.Second];
+	if( ( firstCode | secondCode ) == 0 ) {
+		// Целиком видимый отрезок
+		addSegments( &segment, 1, renderedObject );
+		return;
+	}
+	if( ( firstCode & secondCode ) != 0 ) {
+		// Оба конца снаружи одной и той же плоскости - отрезок невидим
+		return;
+	}
+	const C3DPoint first = TransformMatrix.TransformPoint( CVec3( object.Points[segment.First] ) ).ToPoint();
+	const C3DPoint second = TransformMatrix.TransformPoint( CVec3( object.Points[segment.Second] ) ).ToPoint();
+	double tFirst, tSecond;
+	if( !clipSegment( first, second, tFirst, tSecond ) ) {
+		return;
+	}
+	const C3DPoint direction = second - first;
+	const int firstIndex = firstCode == 0 ? pointsBase + segment.First :
+		addProjectedPoint( first + direction * tFirst, renderedObject );
+	const int secondIndex = secondCode == 0 ? pointsBase + segment.Second :
+		addProjectedPoint( first + direction * tSecond, renderedObject );
+	renderedObject.Segments.push_back( CSegmentIndex( firstIndex, secondIndex ) );
+}
+
+void CEngineCamera::clipAndAddTriangle( const C3DModel& object, const CTriangleIndex& triangle, C2DModel& renderedObject )
+{
+	const unsigned char firstCode = pointOutcodes[pointsBase + triangle.First];
+	const unsigned char secondCode = pointOutcodes[pointsBase + triangle.Second];
+	const unsigned char thirdCode = pointOutcodes[pointsBase + triangle.Third];
+	if( ( firstCode | secondCode | thirdCode ) == 0 ) {
+		addTriangles( &triangle, 1, renderedObject );
+		return;
+	}
+	if( ( firstCode & secondCode & thirdCode ) != 0 ) {
+		return;
+	}
+	const C3DPoint source[3] = {
+		TransformMatrix.TransformPoint( CVec3( object.Points[triangle.First] ) ).ToPoint(),
+		TransformMatrix.TransformPoint( CVec3( object.Points[triangle.Second] ) ).ToPoint(),
+		TransformMatrix.TransformPoint( CVec3( object.Points[triangle.Third] ) ).ToPoint()
+	};
+	const int sourceIndices[3] = { pointsBase + triangle.First, pointsBase + triangle.Second, pointsBase + triangle.Third };
+	C3DPoint polygon[MaxClippedVertices];
+	int indices[MaxClippedVertices];
+	const int size = clipTriangle( source, sourceIndices, polygon, indices );
+	// Номера вершин исходного треугольника сохраняются только для видимых вершин, остальные добавляются заново
+	for( int i = 0; i < size; i++ ) {
+		if( indices[i] < 0 || pointOutcodes[indices[i]] != 0 ) {
+			indices[i] = addProjectedPoint( polygon[i], renderedObject );
 		}
-		counter += 1;
 	}
+	// Выпуклый многоугольник разбиваем веером на треугольники
+	for( int i = 2; i < size; i++ ) {
+		renderedObject.Triangles.push_back( CTriangleIndex( indices[0], indices[i - 1], indices[i] ) );
+	}
+}
 
-	// Теперь мы удаляем все объекты (индексы), которые содержат хотя бы одну точку из отсечённых
-	auto segment = cameraModel.Segments.begin();
-	while( segment != cameraModel.Segments.end() ) {
-		// Если попадает под условие (один из концов находится среди удаляемых точек), то удаляем
-		if( pointNumbersForErase.find( segment->First ) != pointNumbersForErase.end() &&
-			pointNumbersForErase.find( segment->Second ) != pointNumbersForErase.end() ) {
-			segment = cameraModel.Segments.erase( segment );
+bool CEngineCamera::clipSegment( const C3DPoint& first, const C3DPoint& second, double& tFirst, double& tSecond ) const
+{
+	// Алгоритм Лианга-Барски: сужаем отрезок параметров [tFirst, tSecond] по каждой из плоскостей
+	tFirst = 0;
+	tSecond = 1;
+	for( int i = 0; i < ClipPlanesCount; i++ ) {
+		const double firstDistance = clipPlanes[i].Distance( first.X, first.Y, first.Z );
+		const double secondDistance = clipPlanes[i].Distance( second.X, second.Y, second.Z );
+		if( firstDistance < 0 && secondDistance < 0 ) {
+			return false;
 		}
-		// Иначе переходим к следующему элементу
-		else {
-			segment++;
+		if( firstDistance < 0 ) {
+			tFirst = std::max( tFirst, firstDistance / ( firstDistance - secondDistance ) );
+		} else if( secondDistance < 0 ) {
+			tSecond = std::min( tSecond, firstDistance / ( firstDistance - secondDistance ) );
 		}
 	}
+	return tFirst < tSecond;
+}
 
-	// Аналогично и для треугольников
-	auto triangle = cameraModel.Triangles.begin();
-	while( triangle != cameraModel.Triangles.end() ) {
-		// Если попадает под условие (одна из вершин треугольника попадает в точки), то удаляем
-		if( pointNumbersForErase.find( triangle->First ) != pointNumbersForErase.end() &&
-			pointNumbersForErase.find( triangle->Second ) != pointNumbersForErase.end() &&
-			pointNumbersForErase.find( triangle->Third ) != pointNumbersForErase.end() ) {
-			triangle = cameraModel.Triangles.erase( triangle );
+int CEngineCamera::clipTriangle( const C3DPoint source[3], const int sourceIndices[3], C3DPoint* polygon, int* indices ) const
+{
+	// Многоугольник попеременно хранится в двух буферах: отсекаем его по очереди каждой из плоскостей
+	C3DPoint buffer[MaxClippedVertices];
+	int bufferIndices[MaxClippedVertices];
+	int size = 3;
+	for( int i = 0; i < 3; i++ ) {
+		polygon[i] = source[i];
+		indices[i] = sourceIndices[i];
+	}
+
+	for( int plane = 0; plane < ClipPlanesCount && size > 0; plane++ ) {
+		int newSize = 0;
+		for( int i = 0; i < size; i++ ) {
+			const C3DPoint& current = polygon[i];
+			const C3DPoint& next = polygon[( i + 1 ) % size];
+			const double currentDistance = clipPlanes[plane].Distance( current.X, current.Y, current.Z );
+			const double nextDistance = clipPlanes[plane].Distance( next.X, next.Y, next.Z );
+			if( currentDistance >= 0 ) {
+				buffer[newSize] = current;
+				bufferIndices[newSize++] = indices[i];
+			}
+			// Ребро пересекает плоскость - добавляем точку пересечения
+			if( ( currentDistance >= 0 ) != ( nextDistance >= 0 ) ) {
+				const double t = currentDistance / ( currentDistance - nextDistance );
+				buffer[newSize] = current + ( next - current ) * t;
+				bufferIndices[newSize++] = -1;
+			}
 		}
-		// Иначе переходим к следующему элементу
-		else {
-			triangle++;
+		size = newSize;
+		for( int i = 0; i < size; i++ ) {
+			polygon[i] = buffer[i];
+			indices[i] = bufferIndices[i];
 		}
 	}
+	return size;
 }
 
-void CEngineCamera::render( C2DModel& renderedObject ) const
+// Квадрат расстояния между точками на экране
+static double squaredDistance( const C2DPoint& first, const C2DPoint& second )
 {
-	// TODO: преобразование трёхмерных координат точек в контексте камеры в двухмерные координаты в контексте окна
-	renderedObject.Clear();
+	return ( second.X - first.X ) * ( second.X - first.X ) + ( second.Y - first.Y ) * ( second.Y - first.Y );
+}
 
-	// Так как сама структура объекта (отрезки и треугольники) уже не поменяется, то мы просто копируем имеющиеся индексы
-	renderedObject.Triangles = cameraModel.Triangles;
-	renderedObject.Segments = cameraModel.Segments;
+int CEngineCamera::mergeShortSegments( C2DModel& renderedObject, int begin, int end )
+{
+	if( segmentMergeThreshold <= 0 ) {
+		return end;
+	}
+	const double startTime = statisticsEnabled ? CStopwatch::Now() : 0;
+	const double squaredThreshold = segmentMergeThreshold * segmentMergeThreshold;
+	const std::vector<C2DPoint>& points = renderedObject.Points;
+	std::vector<CSegmentIndex>& segments = renderedObject.Segments;
+
+	int last = begin - 1;
+	// Может ли последний оставленный отрезок продолжаться: он короче порога, а все точки поглощённых им
+	// отрезков лежат ближе порога к его началу. Начало объединённого отрезка уже не меняется
+	bool lastIsShort = false;
+	bool lastIsMerged = false;
+	for( int i = begin; i < end; i++ ) {
+		const CSegmentIndex segment = segments[i];
+		const C2DPoint& first = points[segment.First];
+		const C2DPoint& second = points[segment.Second];
+		const bool isShort = squaredDistance( first, second ) < squaredThreshold;
+		if( !isShort ) {
+			segments[++last] = segment;
+			lastIsShort = false;
+			lastIsMerged = false;
+			continue;
+		}
+		// Отрезок внутри одного пикселя ничего не добавляет к изображению
+		if( std::floor( first.X ) == std::floor( second.X ) && std::floor( first.Y ) == std::floor( second.Y ) ) {
+			continue;
+		}
 
-	// Для каждой точки выполняем её аксонометрическое преобразование (то есть проецируем на плоскость обзора камеры)
-	for( auto point = cameraModel.Points.begin(); point != cameraModel.Points.end(); point++ ) {
-		C2DPoint newPoint;
-		newPoint.X = ViewDistance * point->X / point->Z + ( 0.5 * ClientWidth - 0.5 );
-		newPoint.Y = -ViewDistance * point->Y * AspectRatio / point->Z + ( 0.5 * ClientHeight - 0.5 );
-		renderedObject.AddPoint( newPoint );
+		// Короткий отрезок, имеющий общий конец с предыдущим коротким, заменяет его вместе с ним хордой
+		// от начала предыдущего до своего дальнего конца, пока хорда остаётся короче порога
+		if( lastIsShort ) {
+			CSegmentIndex& previous = segments[last];
+			int start = -1;
+			int finish = -1;
+			if( previous.Second == segment.First || previous.Second == segment.Second ) {
+				start = previous.First;
+				finish = previous.Second == segment.First ? segment.Second : segment.First;
+			} else if( !lastIsMerged && ( previous.First == segment.First || previous.First == segment.Second ) ) {
+				start = previous.Second;
+				finish = previous.First == segment.First ? segment.Second : segment.First;
+			}
+			if( start >= 0 && start != finish && squaredDistance( points[start], points[finish] ) < squaredThreshold ) {
+				previous = CSegmentIndex( start, finish );
+				lastIsMerged = true;
+				continue;
+			}
+		}
+		segments[++last] = segment;
+		lastIsShort = true;
+		lastIsMerged = false;
 	}
+
+	if( statisticsEnabled ) {
+		statistics.MergeTime += CStopwatch::Now() - startTime;
+		statistics.MergedSegments += end - ( last + 1 );
+	}
+	return last + 1;
 }
 
-C3DPoint CEngineCamera::modifyPoint( C3DPoint originPoint ) const
+int CEngineCamera::addProjectedPoint( const C3DPoint& point, C2DModel& renderedObject )
 {
-	return TransformMatrix.ProjectPoint( originPoint );
+	C2DPoint newPoint;
+	newPoint.X = ViewDistance * point.X / point.Z + ( 0.5 * ClientWidth - 0.5 );
+	newPoint.Y = -ViewDistance * point.Y * AspectRatio / point.Z + ( 0.5 * ClientHeight - 0.5 );
+	renderedObject.AddPoint( newPoint );
+	renderedDepths.push_back( point.Z );
+	return static_cast<int>( renderedObject.Points.size() ) - 1;
 }
 
 void CEngineCamera::SetPosition( C3DPoint point )
@@ -227,37 +736,10 @@ void CEngineCamera::MoveSide( double speed )
 
 void CEngineCamera::RotateSideAroundCenter( double angle )
 {
-	// Так как при вращении мы изменяем точку направления камеры, то заводим временную переменную
-	C3DPoint newViewPosition;
-
-
-	// Синус и косинус вращаемого угла
-	double cosTheta = std::cos( angle );
-	double sinTheta = std::sin( angle );
-	C3DPoint os = Position - CenterPoint;
-
-	double x = UpVector.X;
-	double y = UpVector.Y;
-	double z = UpVector.Z;
-
-	// Найдем значение X точки вращения
-	newViewPosition.X = ( cosTheta + ( 1 - cosTheta ) * x * x ) * os.X;
-	newViewPosition.X += ( ( 1 - cosTheta ) * x * y - z * sinTheta ) * os.Y;
-	newViewPosition.X += ( ( 1 - cosTheta ) * x * z + y * sinTheta ) * os.Z;
-
-	// И значение Y
-	newViewPosition.Y = ( ( 1 - cosTheta ) * x * y + z * sinTheta ) * os.X;
-	newViewPosition.Y += ( cosTheta + ( 1 - cosTheta ) * y * y ) * os.Y;
-	newViewPosition.Y += ( ( 1 - cosTheta ) * y * z - x * sinTheta ) * os.Z;
-
-	// И Z...
-	newViewPosition.Z = ( ( 1 - cosTheta ) * x * z - y * sinTheta ) * os.X;
-	newViewPosition.Z += ( ( 1 - cosTheta ) * y * z + x * sinTheta ) * os.Y;
-	newViewPosition.Z += ( cosTheta + ( 1 - cosTheta ) * z * z ) * os.Z;
-
-	// Теперь просто прибавим новый вектор к нашей позиции,
-	// чтобы установить новую позицию камеры.
-	Position = newViewPosition + CenterPoint;
+	// Поворачиваем вектор от центра вращения до камеры вокруг оси UpVector
+	// и прибавляем его к центру, чтобы установить новую позицию камеры
+	const CMat4 rotation = CMat4::Rotation( CVec3( UpVector ), angle );
+	Position = rotation.TransformVector( CVec3( Position - CenterPoint ) ).ToPoint() + CenterPoint;
 	SetViewPoint( CenterPoint );
 
 	// Обновляем матрицу преобразования
@@ -267,37 +749,10 @@ void CEngineCamera::RotateSideAroundCenter( double angle )
 
 void CEngineCamera::RotateUpAroundCenter( double angle )
 {
-	// Так как при вращении мы изменяем точку направления камеры, то заводим временную переменную
-	C3DPoint newViewPosition;
-
-
-	// Синус и косинус вращаемого угла
-	double cosTheta = std::cos( angle );
-	double sinTheta = std::sin( angle );
-	C3DPoint os = Position - CenterPoint;
-
-	double x = RightVector.X;
-	double y = RightVector.Y;
-	double z = RightVector.Z;
-
-	// Найдем значение X точки вращения
-	newViewPosition.X = ( cosTheta + ( 1 - cosTheta ) * x * x ) * os.X;
-	newViewPosition.X += ( ( 1 - cosTheta ) * x * y - z * sinTheta ) * os.Y;
-	newViewPosition.X += ( ( 1 - cosTheta ) * x * z + y * sinTheta ) * os.Z;
-
-	// И значение Y
-	newViewPosition.Y = ( ( 1 - cosTheta ) * x * y + z * sinTheta ) * os.X;
-	newViewPosition.Y += ( cosTheta + ( 1 - cosTheta ) * y * y ) * os.Y;
-	newViewPosition.Y += ( ( 1 - cosTheta ) * y * z - x * sinTheta ) * os.Z;
-
-	// И Z...
-	newViewPosition.Z = ( ( 1 - cosTheta ) * x * z - y * sinTheta ) * os.X;
-	newViewPosition.Z += ( ( 1 - cosTheta ) * y * z + x * sinTheta ) * os.Y;
-	newViewPosition.Z += ( cosTheta + ( 1 - cosTheta ) * z * z ) * os.Z;
-
-	// Теперь просто прибавим новый вектор к нашей позиции,
-	// чтобы установить новую позицию камеры.
-	Position = newViewPosition + CenterPoint;
+	// Поворачиваем вектор от центра вращения до камеры вокруг оси RightVector
+	// и прибавляем его к центру, чтобы установить новую позицию камеры
+	const CMat4 rotation = CMat4::Rotation( CVec3( RightVector ), angle );
+	Position = rotation.TransformVector( CVec3( Position - CenterPoint ) ).ToPoint() + CenterPoint;
 	SetViewPoint( CenterPoint );
 
 	// Обновляем матрицу преобразования
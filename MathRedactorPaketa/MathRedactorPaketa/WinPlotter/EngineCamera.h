@@ -1,7 +1,10 @@
 ﻿#pragma once
 #include "3DPoint.h"
-#include "Matrix44.h"
+#include "VectorMath.h"
 #include "Model.h"
+#include "ModelBVH.h"
+#include "Scene.h"
+#include "RenderStatistics.h"
 
 /*
 * Класс движка, который переводит трёхмерные объекты пространства графика в двухмерные объекты контекста окна отрисовки.
@@ -46,9 +49,47 @@ public:
 	// отрисовки в окне программы
 	void Render( const C3DModel& object, C2DModel& renderedObject, bool filtrate = true );
 
+	// Аналог Render с отсечением по иерархии ограничивающих объёмов: части модели, целиком попадающие в область
+	// видимости или целиком лежащие вне её, обрабатываются одной проверкой. Точки, не попавшие в видимые части,
+	// в renderedObject не заполняются. Иерархия должна быть построена по текущему состоянию object
+	void Render( const C3DModel& object, const CModelBVH& hierarchy, C2DModel& renderedObject );
+
+	// Отрисовывает все видимые объекты сцены за один проход в общую двухмерную модель. Точки объектов идут
+	// в ней подряд в порядке объектов, элементы каждого объекта занимают свой диапазон в renderedScene.Objects
+	void Render( const CScene& scene, CRenderedScene& renderedScene );
+
+	// Выбирает уровень детализации для текущего положения камеры: самый подробный уровень, отрезки которого
+	// на экране не короче порога. Более подробные уровни отличались бы лишь деталями меньше порога
+	int SelectLevel( const CModelLOD& levels ) const;
+
+	// Устанавливает порог выбора уровня детализации (длина отрезка на экране в пикселях)
+	void SetLevelOfDetailThreshold( double pixels ) { levelOfDetailThreshold = pixels; }
+
+	// Устанавливает число потоков, на которых проецируются большие модели (0 - по числу ядер процессора)
+	void SetThreadsCount( int threadsCount );
+
+	// Устанавливает порог объединения отрезков (доля пикселя). После проецирования идущие подряд отрезки короче
+	// порога объединяются в один, а отрезки, оба конца которых попали в один пиксель, отбрасываются.
+	// 0 отключает объединение
+	void SetSegmentMergeThreshold( double pixels ) { segmentMergeThreshold = pixels; }
+
+	// Возвращает глубины (координату Z в системе камеры) точек модели, полученной последним вызовом Render.
+	// Номера совпадают с номерами точек renderedObject
+	const std::vector<double>& GetDepths() const { return renderedDepths; }
+
 	// функция возвращающая движок в начальное состояние
 	void Reset();
 
+	// Включает сбор времени стадий и счётчиков при каждом вызове Render. Выключенный сбор ничего не стоит
+	void EnableStatistics( bool enable ) { statisticsEnabled = enable; }
+	bool IsStatisticsEnabled() const { return statisticsEnabled; }
+	// Статистика последнего вызова Render (при включённом сборе)
+	const CRenderStatistics& GetStatistics() const { return statistics; }
+
+	// Возвращает версию состояния камеры: она меняется при любом изменении положения, направления камеры
+	// или размеров проекции. Совпадение версий означает, что проекция неизменной модели осталась прежней
+	unsigned int GetVersion() const { return version; }
+
 private:
 	// Положение камеры в трёхмерном пространстве
 	C3DPoint Position;
@@ -70,10 +111,13 @@ private:
 	void UpdateUpVector();
 
 	// Матрица преобразования координат из системы XYZ объекта в систему UVN
-	CMatrix44 TransformMatrix;
+	CMat4 TransformMatrix;
 	// Обновляет эту матрицу в случае изменения положения и вращения камеры
 	void UpdateTransformMatrix();
 
+	// Версия состояния камеры, увеличивается при каждом изменении матрицы преобразования или размеров проекции
+	unsigned int version;
+
 	// Размер шага передвижения камеры
 	double stepSize;
 
@@ -91,19 +135,112 @@ private:
 	// Исключение, вызываемое при неверно переданных параметрах размеров проекции
 	class IncorrectWindowSize {};
 
-	// Структура, хранящая координаты модели в пространстве камеры
-	C3DModel cameraModel;
-
-	// Внутренний метод, который создаёт локальную версию объекта с координатами камеры
-	void transform( const C3DModel& object );
-	
-	// Фильтрует узлы и элементы модели, которые не попадают в область обзора камеры
-	void filter();
-
-	// Проецирует точки внутренней структуры в двухмерную модель для отрисовки на экране
-	void render( C2DModel& renderedObject ) const;
-
-	// Возвращает преобразованные координаты точки при помощи матрицы преобразований
-	C3DPoint modifyPoint( C3DPoint originPoint ) const;
+	// Исключение, вызываемое при рендере модели по иерархии, построенной для другого состояния модели
+	class OutdatedHierarchy {};
+
+	// Количество точек, которые за один проход преобразуются, отсекаются и проецируются, пока лежат в кэше
+	static const int BlockSize = 256;
+	// Начиная с этого числа точек проецирование делится между потоками: на меньших моделях запуск потоков
+	// обходится дороже самой работы
+	static const int ParallelProjectionThreshold = 1 << 16;
+	// Число потоков для проецирования больших моделей
+	int threadsCount;
+
+	// Плоскости пирамиды видимости камеры. Точка (x, y, z) в системе камеры лежит внутри плоскости,
+	// если A * x + B * y + C * z + D >= 0
+	struct CClipPlane {
+		double A, B, C, D;
+		double Distance( double x, double y, double z ) const { return A * x + B * y + C * z + D; }
+	};
+	static const int ClipPlanesCount = 6;
+	CClipPlane clipPlanes[ClipPlanesCount];
+	// Пересчитывает плоскости отсечения по текущим размерам проекции
+	void updateClipPlanes();
+
+	// Код положения точки относительно пирамиды видимости: бит i выставлен, если точка снаружи i-й плоскости.
+	// Заполняется при проецировании, память переиспользуется между кадрами
+	std::vector<unsigned char> pointOutcodes;
+	// Есть ли хотя бы одна точка вне пирамиды видимости
+	bool hasCulledPoints;
+	// Возвращает код положения точки, заданной в системе камеры
+	unsigned char outcode( double x, double y, double z ) const;
+
+	// Максимальное число вершин многоугольника при отсечении треугольника шестью плоскостями
+	static const int MaxClippedVertices = 3 + ClipPlanesCount;
+	// Стек узлов при обходе иерархии (переиспользуемый буфер)
+	std::vector<int> nodesStack;
+
+	// Порог выбора уровня детализации в пикселях
+	double levelOfDetailThreshold;
+
+	// Порог объединения отрезков в пикселях
+	double segmentMergeThreshold;
+
+	// Модели и иерархии объектов сцены, выбранные для текущего кадра (0 для невидимых объектов)
+	std::vector< std::pair<const C3DModel*, const CModelBVH*> > sceneModels;
+
+	// Номер, начиная с которого точки обрабатываемой модели лежат в выходной двухмерной модели (ненулевой
+	// при отрисовке сцены). На него сдвигаются номера точек в pointOutcodes, renderedDepths и в индексах элементов
+	int pointsBase;
+
+	// Проецирует все точки объекта в двухмерную модель за один проход. Без фильтрации топология копируется как есть
+	void transformAndProject( const C3DModel& object, C2DModel& renderedObject, bool filtrate );
+
+	// Проецирует точки объекта с номерами indices[0..count) (или первые count точек, если indices == 0):
+	// каждая точка переводится в систему камеры, при фильтрации получает код положения относительно области
+	// видимости и сразу проецируется на экран в renderedObject.Points под своим номером. Номера не должны повторяться
+	void projectPoints( const C3DModel& object, const int* indices, int count, C2DModel& renderedObject, bool filtrate );
+	// Проецирует точки с номерами в [begin, end) из того же набора, возвращает число точек вне области видимости.
+	// Разные диапазоны можно обрабатывать одновременно в разных потоках
+	int projectRange( const C3DModel& object, const int* indices, int begin, int end, C2DModel& renderedObject,
+		bool filtrate );
+
+	// Отсекает элементы модели по пирамиде видимости: невидимые отбрасываются, частично видимые обрезаются
+	// до видимой части (новые вершины дописываются в конец renderedObject.Points)
+	void filter( const C3DModel& object, C2DModel& renderedObject );
+	// То же, но видимые элементы дописываются к уже имеющимся в renderedObject
+	void addFiltered( const C3DModel& object, C2DModel& renderedObject );
+
+	// Обходит иерархию модели, проецируя видимые части и дописывая их элементы в renderedObject.
+	// Под точки модели в renderedObject уже должно быть выделено место
+	void renderHierarchy( const C3DModel& object, const CModelBVH& hierarchy, C2DModel& renderedObject );
+
+	// Дописывает элементы в renderedObject без отсечения, сдвигая номера точек на pointsBase
+	void addSegments( const CSegmentIndex* segments, int count, C2DModel& renderedObject ) const;
+	void addTriangles( const CTriangleIndex* triangles, int count, C2DModel& renderedObject ) const;
+
+	// Отсекает один элемент модели и дописывает его видимую часть в renderedObject
+	void clipAndAddSegment( const C3DModel& object, const CSegmentIndex& segment, C2DModel& renderedObject );
+	void clipAndAddTriangle( const C3DModel& object, const CTriangleIndex& triangle, C2DModel& renderedObject );
+
+	// Отсекает отрезок в системе камеры. Возвращает false, если он целиком невидим, иначе записывает
+	// параметры концов видимой части (0 - начало, 1 - конец исходного отрезка)
+	bool clipSegment( const C3DPoint& first, const C3DPoint& second, double& tFirst, double& tSecond ) const;
+
+	// Отсекает треугольник в системе камеры алгоритмом Сазерленда-Ходжмана. Возвращает число вершин
+	// получившегося выпуклого многоугольника (0, если треугольник невидим). Для вершин исходного треугольника
+	// в indices записывается их номер, для новых вершин - -1
+	int clipTriangle( const C3DPoint source[3], const int sourceIndices[3], C3DPoint* polygon, int* indices ) const;
+
+	// Объединяет идущие подряд короткие отрезки renderedObject.Segments[begin, end) и отбрасывает отрезки внутри
+	// одного пикселя. Оставшиеся отрезки сдвигаются к началу диапазона, возвращает его новый конец
+	int mergeShortSegments( C2DModel& renderedObject, int begin, int end );
+
+	// Проецирует точку в системе камеры на экран и добавляет её в renderedObject, возвращает её номер
+	int addProjectedPoint( const C3DPoint& point, C2DModel& renderedObject );
+
+	// Глубины точек последней отрисованной модели
+	std::vector<double> renderedDepths;
+
+	// Сбор статистики
+	bool statisticsEnabled;
+	CRenderStatistics statistics;
+	// Время начала текущего вызова Render
+	double renderStartTime;
+	// Начинает и завершает сбор статистики вызова Render
+	void beginStatistics();
+	void endStatistics( const C2DModel& renderedObject );
+	// Учитывает модель, поступившую на вход
+	void countInput( const C3DModel& object );
 };
 
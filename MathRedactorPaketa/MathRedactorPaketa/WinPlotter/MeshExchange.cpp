@@ -0,0 +1,886 @@
+﻿#include "MeshExchange.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+	// Размер буфера блочного ввода-вывода
+	const size_t BufferSize = 1 << 20;
+	// Размер блока OBJ, который делится между потоками, и минимальная часть на поток
+	const size_t ObjChunkSize = 16 << 20;
+	const size_t ObjMinPartSize = 256 << 10;
+
+	// Чтение файла через буфер
+	class CInputBuffer {
+	public:
+		explicit CInputBuffer( const std::string& fileName ) :
+			stream( fileName.c_str(), std::ifstream::binary ), buffer( BufferSize ), position( 0 ), end( 0 )
+		{
+			if( !stream ) {
+				throw CMeshExchange::CannotOpen();
+			}
+		}
+
+		// Размер файла в байтах
+		unsigned long long Size()
+		{
+			const std::streampos current = stream.tellg();
+			stream.seekg( 0, std::ifstream::end );
+			const unsigned long long size = static_cast<unsigned long long>( stream.tellg() );
+			stream.seekg( current );
+			return size;
+		}
+
+		// Читает ровно size байт, при нехватке данных бросает BadFormat
+		void Read( void* destination, size_t size )
+		{
+			char* output = static_cast<char*>( destination );
+			while( size > 0 ) {
+				if( position == end && !fill() ) {
+					throw CMeshExchange::BadFormat();
+				}
+				const size_t count = std::min( size, end - position );
+				std::memcpy( output, &buffer[position], count );
+				position += count;
+				output += count;
+				size -= count;
+			}
+		}
+
+		// Читает строку заголовка (без перевода строки) в line, возвращает false в конце файла
+		bool ReadLine( std::string& line )
+		{
+			line.clear();
+			while( true ) {
+				if( position == end && !fill() ) {
+					return !line.empty();
+				}
+				const char* begin = &buffer[position];
+				const char* newLine = static_cast<const char*>( std::memchr( begin, '\n', end - position ) );
+				const size_t count = newLine != 0 ? newLine - begin : end - position;
+				line.append( begin, count );
+				position += count;
+				if( newLine != 0 ) {
+					position++;
+					if( !line.empty() && line[line.size() - 1] == '\r' ) {
+						line.erase( line.size() - 1 );
+					}
+					return true;
+				}
+			}
+		}
+
+	private:
+		std::ifstream stream;
+		std::vector<char> buffer;
+		size_t position;
+		size_t end;
+
+		bool fill()
+		{
+			stream.read( buffer.data(), static_cast<std::streamsize>( buffer.size() ) );
+			position = 0;
+			end = static_cast<size_t>( stream.gcount() );
+			return end > 0;
+		}
+	};
+
+	// Запись файла через буфер
+	class COutputBuffer {
+	public:
+		explicit COutputBuffer( const std::string& fileName ) :
+			stream( fileName.c_str(), std::ofstream::binary | std::ofstream::trunc ), size( 0 )
+		{
+			if( !stream ) {
+				throw CMeshExchange::CannotOpen();
+			}
+			buffer.resize( BufferSize );
+		}
+
+		void Write( const void* data, size_t count )
+		{
+			const char* input = static_cast<const char*>( data );
+			while( count > 0 ) {
+				if( size == buffer.size() ) {
+					flushBuffer();
+				}
+				const size_t part = std::min( count, buffer.size() - size );
+				std::memcpy( &buffer[size], input, part );
+				size += part;
+				input += part;
+				count -= part;
+			}
+		}
+
+		void Write( const std::string& text )
+		{
+			Write( text.data(), text.size() );
+		}
+
+		template<typename T>
+		void WriteValue( T value )
+		{
+			Write( &value, sizeof( value ) );
+		}
+
+		// Записывает остаток буфера, при ошибке бросает CannotOpen
+		void Close()
+		{
+			flushBuffer();
+			stream.flush();
+			if( !stream ) {
+				throw CMeshExchange::CannotOpen();
+			}
+			stream.close();
+		}
+
+	private:
+		std::ofstream stream;
+		std::vector<char> buffer;
+		size_t size;
+
+		void flushBuffer()
+		{
+			stream.write( buffer.data(), static_cast<std::streamsize>( size ) );
+			size = 0;
+		}
+	};
+
+	// Расширение файла в нижнем регистре, включая точку
+	std::string extension( const std::string& fileName )
+	{
+		const size_t dot = fileName.find_last_of( '.' );
+		if( dot == std::string::npos || fileName.find_first_of( "/\\", dot ) != std::string::npos ) {
+			return std::string();
+		}
+		std::string result = fileName.substr( dot );
+		for( size_t i = 0; i < result.size(); i++ ) {
+			result[i] = static_cast<char>( std::tolower( static_cast<unsigned char>( result[i] ) ) );
+		}
+		return result;
+	}
+
+	// Добавляет отрезок и треугольник, пропуская вырожденные. Индексы проверяются по числу точек модели
+	void addSegment( C3DModel& model, int first, int second )
+	{
+		const int pointsCount = static_cast<int>( model.Points.size() );
+		if( first < 0 || second < 0 || first >= pointsCount || second >= pointsCount ) {
+			throw CMeshExchange::BadFormat();
+		}
+		if( first != second ) {
+			model.Segments.push_back( CSegmentIndex( first, second ) );
+		}
+	}
+
+	void addTriangle( C3DModel& model, int first, int second, int third )
+	{
+		const int pointsCount = static_cast<int>( model.Points.size() );
+		if( first < 0 || second < 0 || third < 0 || first >= pointsCount || second >= pointsCount || third >= pointsCount ) {
+			throw CMeshExchange::BadFormat();
+		}
+		if( first != second && second != third && first != third ) {
+			model.Triangles.push_back( CTriangleIndex( first, second, third ) );
+		}
+	}
+
+	// ---------------------------------------------------------------------------------------------------------
+	// OBJ
+
+	// Результат разбора части блока OBJ. Отрицательные (относительные) индексы отсчитываются от начала части,
+	// их позиции запоминаются, чтобы сдвинуть на число точек перед частью, когда оно станет известно
+	struct CObjPart {
+		std::vector<C3DPoint> Points;
+		std::vector<int> Segments;
+		std::vector<int> Triangles;
+		std::vector<size_t> RelativeSegments;
+		std::vector<size_t> RelativeTriangles;
+		bool Failed;
+
+		void Clear()
+		{
+			Points.clear();
+			Segments.clear();
+			Triangles.clear();
+			RelativeSegments.clear();
+			RelativeTriangles.clear();
+			Failed = false;
+		}
+	};
+
+	bool isBlank( char c )
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	bool isLineEnd( char c )
+	{
+		return c == '\n' || c == '\r' || c == '#';
+	}
+
+	void skipBlanks( const char*& position )
+	{
+		while( isBlank( *position ) ) {
+			position++;
+		}
+	}
+
+	// Читает число с плавающей точкой, не выходя за конец строки. Значения nan и inf разбираются отдельно,
+	// потому что strtod в VS2013 их не понимает
+	bool parseDouble( const char*& position, double& value )
+	{
+		skipBlanks( position );
+		if( isLineEnd( *position ) ) {
+			return false;
+		}
+		const char* start = position + ( *position == '-' || *position == '+' ? 1 : 0 );
+		const char first = static_cast<char>( std::tolower( static_cast<unsigned char>( *start ) ) );
+		if( first == 'n' || first == 'i' ) {
+			const double special = first == 'n' ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+			value = *position == '-' ? -special : special;
+			position = start;
+			while( std::isalpha( static_cast<unsigned char>( *position ) ) ) {
+				position++;
+			}
+			return true;
+		}
+		char* end = 0;
+		value = std::strtod( position, &end );
+		if( end == position ) {
+			return false;
+		}
+		position = end;
+		return true;
+	}
+
+	// Читает номер вершины из элемента грани (v, v/vt, v//vn, v/vt/vn). Номера OBJ начинаются с 1
+	bool parseIndex( const char*& position, int& value, bool& relative )
+	{
+		skipBlanks( position );
+		if( isLineEnd( *position ) ) {
+			return false;
+		}
+		const bool negative = *position == '-';
+		if( negative ) {
+			position++;
+		}
+		if( !std::isdigit( static_cast<unsigned char>( *position ) ) ) {
+			return false;
+		}
+		long long number = 0;
+		while( std::isdigit( static_cast<unsigned char>( *position ) ) ) {
+			number = std::min( number * 10 + ( *position - '0' ), static_cast<long long>( std::numeric_limits<int>::max() ) );
+			position++;
+		}
+		// Номера текстурных координат и нормалей пропускаем
+		while( !isBlank( *position ) && !isLineEnd( *position ) ) {
+			position++;
+		}
+		value = static_cast<int>( number );
+		relative = negative;
+		return number != 0;
+	}
+
+	// Разбирает строки [begin, end). Конец диапазона - сразу после перевода строки
+	void parseObjPart( const char* begin, const char* end, CObjPart& part )
+	{
+		part.Clear();
+		std::vector<int> polygon;
+		std::vector<char> polygonRelative;
+		const char* position = begin;
+		while( position < end ) {
+			skipBlanks( position );
+			const char type = *position;
+			if( ( type == 'v' || type == 'f' || type == 'l' ) && isBlank( position[1] ) ) {
+				position += 2;
+				if( type == 'v' ) {
+					C3DPoint point;
+					if( !parseDouble( position, point.X ) || !parseDouble( position, point.Y ) || !parseDouble( position, point.Z ) ) {
+						part.Failed = true;
+						return;
+					}
+					part.Points.push_back( point );
+				} else {
+					polygon.clear();
+					polygonRelative.clear();
+					int index;
+					bool relative;
+					while( parseIndex( position, index, relative ) ) {
+						// Абсолютные номера переводим в отсчёт от 0, относительные - в отсчёт от начала части
+						polygon.push_back( relative ? static_cast<int>( part.Points.size() ) - index : index - 1 );
+						polygonRelative.push_back( relative ? 1 : 0 );
+					}
+					skipBlanks( position );
+					if( !isLineEnd( *position ) ) {
+						part.Failed = true;
+						return;
+					}
+					if( type == 'l' ) {
+						for( size_t i = 0; i + 1 < polygon.size(); i++ ) {
+							for( size_t j = i; j <= i + 1; j++ ) {
+								if( polygonRelative[j] != 0 ) {
+									part.RelativeSegments.push_back( part.Segments.size() );
+								}
+								part.Segments.push_back( polygon[j] );
+							}
+						}
+					} else {
+						for( size_t i = 1; i + 1 < polygon.size(); i++ ) {
+							const size_t corners[3] = { 0, i, i + 1 };
+							for( int j = 0; j < 3; j++ ) {
+								if( polygonRelative[corners[j]] != 0 ) {
+									part.RelativeTriangles.push_back( part.Triangles.size() );
+								}
+								part.Triangles.push_back( polygon[corners[j]] );
+							}
+						}
+					}
+				}
+			}
+			// Остаток строки (комментарии, vt, vn, g, o, usemtl и прочее) пропускаем
+			const char* newLine = static_cast<const char*>( std::memchr( position, '\n', end - position ) );
+			position = newLine != 0 ? newLine + 1 : end;
+		}
+	}
+
+	// Переносит разобранную часть в модель
+	void appendObjPart( CObjPart& part, C3DModel& model )
+	{
+		if( part.Failed ) {
+			throw CMeshExchange::BadFormat();
+		}
+		const int base = static_cast<int>( model.Points.size() );
+		for( size_t i = 0; i < part.RelativeSegments.size(); i++ ) {
+			part.Segments[part.RelativeSegments[i]] += base;
+		}
+		for( size_t i = 0; i < part.RelativeTriangles.size(); i++ ) {
+			part.Triangles[part.RelativeTriangles[i]] += base;
+		}
+		model.Points.insert( model.Points.end(), part.Points.begin(), part.Points.end() );
+		// Номера проверяются после чтения всего файла: грань может ссылаться на вершину, описанную ниже
+		for( size_t i = 0; i < part.Segments.size(); i += 2 ) {
+			const int first = part.Segments[i];
+			const int second = part.Segments[i + 1];
+			if( first < 0 || second < 0 ) {
+				throw CMeshExchange::BadFormat();
+			}
+			if( first != second ) {
+				model.Segments.push_back( CSegmentIndex( first, second ) );
+			}
+		}
+		for( size_t i = 0; i < part.Triangles.size(); i += 3 ) {
+			const int first = part.Triangles[i];
+			const int second = part.Triangles[i + 1];
+			const int third = part.Triangles[i + 2];
+			if( first < 0 || second < 0 || third < 0 ) {
+				throw CMeshExchange::BadFormat();
+			}
+			if( first != second && second != third && first != third ) {
+				model.Triangles.push_back( CTriangleIndex( first, second, third ) );
+			}
+		}
+	}
+
+	// ---------------------------------------------------------------------------------------------------------
+	// PLY
+
+	enum TPlyType { PT_Int8, PT_UInt8, PT_Int16, PT_UInt16, PT_Int32, PT_UInt32, PT_Float32, PT_Float64 };
+
+	bool parsePlyType( const std::string& name, TPlyType& type )
+	{
+		static const char* const names[][2] = {
+			{ "char", "int8" }, { "uchar", "uint8" }, { "short", "int16" }, { "ushort", "uint16" },
+			{ "int", "int32" }, { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" }
+		};
+		for( int i = 0; i < 8; i++ ) {
+			if( name == names[i][0] || name == names[i][1] ) {
+				type = static_cast<TPlyType>( i );
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t plyTypeSize( TPlyType type )
+	{
+		static const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+		return sizes[type];
+	}
+
+	struct CPlyProperty {
+		std::string Name;
+		TPlyType Type;
+		bool IsList;
+		TPlyType CountType;
+	};
+
+	struct CPlyElement {
+		std::string Name;
+		unsigned long long Count;
+		std::vector<CPlyProperty> Properties;
+	};
+
+	// Читает значение свойства PLY, при необходимости переставляя байты
+	double readPlyValue( CInputBuffer& input, TPlyType type, bool swapBytes )
+	{
+		unsigned char bytes[8];
+		const size_t size = plyTypeSize( type );
+		input.Read( bytes, size );
+		if( swapBytes ) {
+			std::reverse( bytes, bytes + size );
+		}
+		switch( type ) {
+			case PT_Int8: { signed char value; std::memcpy( &value, bytes, size ); return value; }
+			case PT_UInt8: return bytes[0];
+			case PT_Int16: { short value; std::memcpy( &value, bytes, size ); return value; }
+			case PT_UInt16: { unsigned short value; std::memcpy( &value, bytes, size ); return value; }
+			case PT_Int32: { int value; std::memcpy( &value, bytes, size ); return value; }
+			case PT_UInt32: { unsigned int value; std::memcpy( &value, bytes, size ); return value; }
+			case PT_Float32: { float value; std::memcpy( &value, bytes, size ); return value; }
+			default: { double value; std::memcpy( &value, bytes, size ); return value; }
+		}
+	}
+
+	// Номер вершины из значения свойства PLY
+	int plyIndex( double value )
+	{
+		if( !( value >= 0 && value <= std::numeric_limits<int>::max() ) ) {
+			throw CMeshExchange::BadFormat();
+		}
+		return static_cast<int>( value );
+	}
+
+	bool isLittleEndianHost()
+	{
+		const unsigned int one = 1;
+		unsigned char firstByte;
+		std::memcpy( &firstByte, &one, 1 );
+		return firstByte == 1;
+	}
+
+	// Ключ для объединения совпадающих вершин STL
+	struct CStlVertex {
+		float X, Y, Z;
+
+		bool operator==( const CStlVertex& other ) const { return X == other.X && Y == other.Y && Z == other.Z; }
+	};
+
+	struct CStlVertexHash {
+		size_t operator()( const CStlVertex& vertex ) const
+		{
+			// -0 и 0 равны, поэтому хешируем их одинаково
+			const float coordinates[3] = { vertex.X + 0.0f, vertex.Y + 0.0f, vertex.Z + 0.0f };
+			unsigned int bits[3];
+			std::memcpy( bits, coordinates, sizeof( bits ) );
+			size_t hash = 2166136261u;
+			for( int i = 0; i < 3; i++ ) {
+				hash = ( hash ^ bits[i] ) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+}
+
+bool CMeshExchange::IsSupported( const std::string& fileName )
+{
+	const std::string type = extension( fileName );
+	return type == ".obj" || type == ".stl" || type == ".ply";
+}
+
+void CMeshExchange::Read( const std::string& fileName, C3DModel& model )
+{
+	const std::string type = extension( fileName );
+	if( type == ".obj" ) {
+		ReadOBJ( fileName, model );
+	} else if( type == ".stl" ) {
+		ReadSTL( fileName, model );
+	} else if( type == ".ply" ) {
+		ReadPLY( fileName, model );
+	} else {
+		throw CMeshExchange::BadFormat();
+	}
+}
+
+void CMeshExchange::Write( const C3DModel& model, const std::string& fileName )
+{
+	const std::string type = extension( fileName );
+	if( type == ".obj" ) {
+		WriteOBJ( model, fileName );
+	} else if( type == ".stl" ) {
+		WriteSTL( model, fileName );
+	} else if( type == ".ply" ) {
+		WritePLY( model, fileName );
+	} else {
+		throw CMeshExchange::BadFormat();
+	}
+}
+
+void CMeshExchange::ReadOBJ( const std::string& fileName, C3DModel& model, int threadsCount )
+{
+	std::ifstream stream( fileName.c_str(), std::ifstream::binary );
+	if( !stream ) {
+		throw CMeshExchange::CannotOpen();
+	}
+	if( threadsCount <= 0 ) {
+		threadsCount = std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) );
+	}
+
+	// Модель заполняется целиком, прежде чем заменить переданную, чтобы ошибка в файле не испортила её
+	C3DModel result;
+	std::vector<CObjPart> parts( threadsCount );
+	std::vector<char> chunk;
+	size_t carried = 0;
+	bool finished = false;
+	while( !finished ) {
+		// Дочитываем блок после недоразобранного хвоста предыдущего. Место под завершающий перевод строки
+		chunk.resize( carried + ObjChunkSize + 1 );
+		stream.read( chunk.data() + carried, static_cast<std::streamsize>( ObjChunkSize ) );
+		size_t size = carried + static_cast<size_t>( stream.gcount() );
+		finished = static_cast<size_t>( stream.gcount() ) < ObjChunkSize;
+		size_t parseEnd;
+		if( finished ) {
+			chunk[size++] = '\n';
+			parseEnd = size;
+		} else {
+			// Разбираем только целые строки, хвост переносим в следующий блок
+			parseEnd = size;
+			while( parseEnd > 0 && chunk[parseEnd - 1] != '\n' ) {
+				parseEnd--;
+			}
+			if( parseEnd == 0 ) {
+				carried = size;
+				continue;
+			}
+		}
+
+		// Делим блок на части по границам строк и разбираем их параллельно. Первая часть - в текущем потоке
+		const int partsCount = static_cast<int>( std::max<size_t>( 1,
+			std::min<size_t>( threadsCount, parseEnd / ObjMinPartSize ) ) );
+		std::vector<const char*> bounds( partsCount + 1 );
+		bounds[0] = chunk.data();
+		bounds[partsCount] = chunk.data() + parseEnd;
+		for( int i = 1; i < partsCount; i++ ) {
+			const char* bound = std::max<const char*>( bounds[i - 1], chunk.data() + parseEnd * i / partsCount );
+			while( bound < bounds[partsCount] && bound > chunk.data() && bound[-1] != '\n' ) {
+				bound++;
+			}
+			bounds[i] = bound;
+		}
+		std::vector<std::thread> workers;
+		for( int i = 1; i < partsCount; i++ ) {
+			workers.push_back( std::thread( [&bounds, &parts, i]() { parseObjPart( bounds[i], bounds[i + 1], parts[i] ); } ) );
+		}
+		parseObjPart( bounds[0], bounds[1], parts[0] );
+		for( auto worker = workers.begin(); worker != workers.end(); worker++ ) {
+			worker->join();
+		}
+		for( int i = 0; i < partsCount; i++ ) {
+			appendObjPart( parts[i], result );
+		}
+
+		carried = size - parseEnd;
+		std::memmove( chunk.data(), chunk.data() + parseEnd, carried );
+	}
+
+	const int pointsCount = static_cast<int>( result.Points.size() );
+	for( auto segment = result.Segments.begin(); segment != result.Segments.end(); segment++ ) {
+		if( segment->First >= pointsCount || segment->Second >= pointsCount ) {
+			throw CMeshExchange::BadFormat();
+		}
+	}
+	for( auto triangle = result.Triangles.begin(); triangle != result.Triangles.end(); triangle++ ) {
+		if( triangle->First >= pointsCount || triangle->Second >= pointsCount || triangle->Third >= pointsCount ) {
+			throw CMeshExchange::BadFormat();
+		}
+	}
+	std::swap( model.Points, result.Points );
+	std::swap( model.Segments, result.Segments );
+	std::swap( model.Triangles, result.Triangles );
+}
+
+void CMeshExchange::WriteOBJ( const C3DModel& model, const std::string& fileName )
+{
+	COutputBuffer output( fileName );
+	// Строки собираются в поток в памяти и сбрасываются в буфер файла порциями
+	std::ostringstream text;
+	text.imbue( std::locale::classic() );
+	text.precision( 17 );
+	text << "# WinPlotter\n";
+	const size_t flushSize = 1 << 16;
+	for( auto point = model.Points.begin(); point != model.Points.end(); point++ ) {
+		text << 'v';
+		const double coordinates[3] = { point->X, point->Y, point->Z };
+		for( int i = 0; i < 3; i++ ) {
+			text << ' ';
+			// Вывод nan и inf в VS2013 (1.#QNAN) не читается другими программами
+			if( coordinates[i] != coordinates[i] ) {
+				text << "nan";
+			} else if( std::abs( coordinates[i] ) == std::numeric_limits<double>::infinity() ) {
+				text << ( coordinates[i] < 0 ? "-inf" : "inf" );
+			} else {
+				text << coordinates[i];
+			}
+		}
+		text << '\n';
+		if( static_cast<size_t>( text.tellp() ) >= flushSize ) {
+			output.Write( text.str() );
+			text.str( std::string() );
+		}
+	}
+	for( auto segment = model.Segments.begin(); segment != model.Segments.end(); segment++ ) {
+		text << "l " << segment->First + 1 << ' ' << segment->Second + 1 << '\n';
+		if( static_cast<size_t>( text.tellp() ) >= flushSize ) {
+			output.Write( text.str() );
+			text.str( std::string() );
+		}
+	}
+	for( auto triangle = model.Triangles.begin(); triangle != model.Triangles.end(); triangle++ ) {
+		text << "f " << triangle->First + 1 << ' ' << triangle->Second + 1 << ' ' << triangle->Third + 1 << '\n';
+		if( static_cast<size_t>( text.tellp() ) >= flushSize ) {
+			output.Write( text.str() );
+			text.str( std::string() );
+		}
+	}
+	output.Write( text.str() );
+	output.Close();
+}
+
+void CMeshExchange::ReadSTL( const std::string& fileName, C3DModel& model )
+{
+	CInputBuffer input( fileName );
+	const unsigned long long fileSize = input.Size();
+	char header[80];
+	unsigned int trianglesCount = 0;
+	input.Read( header, sizeof( header ) );
+	input.Read( &trianglesCount, sizeof( trianglesCount ) );
+	// Размер двоичного STL однозначно задаётся числом треугольников. Текстовые STL сюда не подходят
+	if( fileSize != 84 + 50ULL * trianglesCount ) {
+		throw CMeshExchange::BadFormat();
+	}
+
+	C3DModel result;
+	std::unordered_map<CStlVertex, int, CStlVertexHash> vertices;
+	vertices.reserve( trianglesCount );
+	result.Triangles.reserve( trianglesCount );
+	for( unsigned int i = 0; i < trianglesCount; i++ ) {
+		// Нормаль, три вершины и два байта атрибутов
+		float record[12];
+		unsigned short attributes;
+		input.Read( record, sizeof( record ) );
+		input.Read( &attributes, sizeof( attributes ) );
+		int indices[3];
+		for( int j = 0; j < 3; j++ ) {
+			const CStlVertex vertex = { record[3 + 3 * j], record[4 + 3 * j], record[5 + 3 * j] };
+			auto inserted = vertices.insert( std::make_pair( vertex, static_cast<int>( result.Points.size() ) ) );
+			if( inserted.second ) {
+				result.Points.push_back( C3DPoint( vertex.X, vertex.Y, vertex.Z ) );
+			}
+			indices[j] = inserted.first->second;
+		}
+		addTriangle( result, indices[0], indices[1], indices[2] );
+	}
+	std::swap( model.Points, result.Points );
+	std::swap( model.Segments, result.Segments );
+	std::swap( model.Triangles, result.Triangles );
+}
+
+void CMeshExchange::WriteSTL( const C3DModel& model, const std::string& fileName )
+{
+	COutputBuffer output( fileName );
+	char header[80] = "WinPlotter binary STL";
+	output.Write( header, sizeof( header ) );
+	output.WriteValue( static_cast<unsigned int>( model.Triangles.size() ) );
+	for( auto triangle = model.Triangles.begin(); triangle != model.Triangles.end(); triangle++ ) {
+		const C3DPoint& first = model.Points[triangle->First];
+		const C3DPoint& second = model.Points[triangle->Second];
+		const C3DPoint& third = model.Points[triangle->Third];
+		C3DPoint normal = ( second - first ).cross( third - first );
+		const double length = normal.length();
+		normal = length > 0 ? normal / length : C3DPoint();
+		const float record[12] = {
+			static_cast<float>( normal.X ), static_cast<float>( normal.Y ), static_cast<float>( normal.Z ),
+			static_cast<float>( first.X ), static_cast<float>( first.Y ), static_cast<float>( first.Z ),
+			static_cast<float>( second.X ), static_cast<float>( second.Y ), static_cast<float>( second.Z ),
+			static_cast<float>( third.X ), static_cast<float>( third.Y ), static_cast<float>( third.Z )
+		};
+		output.Write( record, sizeof( record ) );
+		output.WriteValue( static_cast<unsigned short>( 0 ) );
+	}
+	output.Close();
+}
+
+void CMeshExchange::ReadPLY( const std::string& fileName, C3DModel& model )
+{
+	CInputBuffer input( fileName );
+	std::string line;
+	if( !input.ReadLine( line ) || line != "ply" ) {
+		throw CMeshExchange::BadFormat();
+	}
+
+	// Заголовок: формат и описания элементов
+	std::vector<CPlyElement> elements;
+	bool formatFound = false;
+	bool swapBytes = false;
+	while( true ) {
+		if( !input.ReadLine( line ) ) {
+			throw CMeshExchange::BadFormat();
+		}
+		std::istringstream words( line );
+		std::string keyword;
+		words >> keyword;
+		if( keyword == "end_header" ) {
+			break;
+		} else if( keyword == "format" ) {
+			std::string format;
+			words >> format;
+			if( format == "binary_little_endian" || format == "binary_big_endian" ) {
+				swapBytes = ( format == "binary_little_endian" ) != isLittleEndianHost();
+				formatFound = true;
+			} else {
+				throw CMeshExchange::BadFormat();
+			}
+		} else if( keyword == "element" ) {
+			CPlyElement element;
+			if( !( words >> element.Name >> element.Count ) ) {
+				throw CMeshExchange::BadFormat();
+			}
+			elements.push_back( element );
+		} else if( keyword == "property" ) {
+			CPlyProperty property;
+			std::string typeName;
+			words >> typeName;
+			property.IsList = typeName == "list";
+			property.CountType = PT_UInt8;
+			if( property.IsList ) {
+				std::string countTypeName;
+				words >> countTypeName >> typeName;
+				if( !parsePlyType( countTypeName, property.CountType ) ) {
+					throw CMeshExchange::BadFormat();
+				}
+			}
+			if( elements.empty() || !parsePlyType( typeName, property.Type ) || !( words >> property.Name ) ) {
+				throw CMeshExchange::BadFormat();
+			}
+			elements.back().Properties.push_back( property );
+		}
+		// comment и obj_info пропускаем
+	}
+	if( !formatFound ) {
+		throw CMeshExchange::BadFormat();
+	}
+
+	// Тело: элементы идут в порядке описания. Вершины, грани и рёбра разбираем, остальное пропускаем
+	C3DModel result;
+	std::vector<std::pair<int, int> > edges;
+	std::vector<int> polygon;
+	std::vector<double> values;
+	for( auto element = elements.begin(); element != elements.end(); element++ ) {
+		const std::vector<CPlyProperty>& properties = element->Properties;
+		const bool isVertex = element->Name == "vertex";
+		const bool isFace = element->Name == "face";
+		const bool isEdge = element->Name == "edge";
+		int x = -1, y = -1, z = -1, first = -1, second = -1, indices = -1;
+		for( int i = 0; i < static_cast<int>( properties.size() ); i++ ) {
+			const std::string& name = properties[i].Name;
+			if( !properties[i].IsList ) {
+				x = name == "x" ? i : x;
+				y = name == "y" ? i : y;
+				z = name == "z" ? i : z;
+				first = name == "vertex1" ? i : first;
+				second = name == "vertex2" ? i : second;
+			} else if( name == "vertex_indices" || name == "vertex_index" ) {
+				indices = i;
+			}
+		}
+		if( ( isVertex && ( x < 0 || y < 0 || z < 0 ) ) || element->Count > static_cast<unsigned long long>( std::numeric_limits<int>::max() ) ) {
+			throw CMeshExchange::BadFormat();
+		}
+		if( isVertex ) {
+			result.Points.reserve( static_cast<size_t>( element->Count ) );
+		}
+		values.resize( properties.size() );
+		for( unsigned long long item = 0; item < element->Count; item++ ) {
+			for( int i = 0; i < static_cast<int>( properties.size() ); i++ ) {
+				const CPlyProperty& property = properties[i];
+				if( !property.IsList ) {
+					values[i] = readPlyValue( input, property.Type, swapBytes );
+					continue;
+				}
+				const double count = readPlyValue( input, property.CountType, swapBytes );
+				if( !( count >= 0 && count <= 1 << 16 ) ) {
+					throw CMeshExchange::BadFormat();
+				}
+				polygon.clear();
+				for( int j = 0; j < static_cast<int>( count ); j++ ) {
+					const double value = readPlyValue( input, property.Type, swapBytes );
+					if( i == indices ) {
+						polygon.push_back( plyIndex( value ) );
+					}
+				}
+			}
+			if( isVertex ) {
+				result.Points.push_back( C3DPoint( values[x], values[y], values[z] ) );
+			} else if( isFace && indices >= 0 ) {
+				// Грани могут идти раньше вершин, поэтому номера проверяются после чтения всего файла
+				for( size_t i = 1; i + 1 < polygon.size(); i++ ) {
+					if( polygon[0] != polygon[i] && polygon[i] != polygon[i + 1] && polygon[0] != polygon[i + 1] ) {
+						result.Triangles.push_back( CTriangleIndex( polygon[0], polygon[i], polygon[i + 1] ) );
+					}
+				}
+			} else if( isEdge && first >= 0 && second >= 0 ) {
+				edges.push_back( std::make_pair( plyIndex( values[first] ), plyIndex( values[second] ) ) );
+			}
+		}
+	}
+
+	const int pointsCount = static_cast<int>( result.Points.size() );
+	for( auto triangle = result.Triangles.begin(); triangle != result.Triangles.end(); triangle++ ) {
+		if( triangle->First >= pointsCount || triangle->Second >= pointsCount || triangle->Third >= pointsCount ) {
+			throw CMeshExchange::BadFormat();
+		}
+	}
+	for( auto edge = edges.begin(); edge != edges.end(); edge++ ) {
+		addSegment( result, edge->first, edge->second );
+	}
+	std::swap( model.Points, result.Points );
+	std::swap( model.Segments, result.Segments );
+	std::swap( model.Triangles, result.Triangles );
+}
+
+void CMeshExchange::WritePLY( const C3DModel& model, const std::string& fileName )
+{
+	COutputBuffer output( fileName );
+	std::ostringstream header;
+	header << "ply\n"
+		<< "format " << ( isLittleEndianHost() ? "binary_little_endian" : "binary_big_endian" ) << " 1.0\n"
+		<< "comment WinPlotter\n"
+		<< "element vertex " << model.Points.size() << "\n"
+		<< "property double x\nproperty double y\nproperty double z\n"
+		<< "element face " << model.Triangles.size() << "\n"
+		<< "property list uchar int vertex_indices\n"
+		<< "element edge " << model.Segments.size() << "\n"
+		<< "property int vertex1\nproperty int vertex2\n"
+		<< "end_header\n";
+	output.Write( header.str() );
+	// Раскладка C3DPoint и CSegmentIndex совпадает с записями вершин и рёбер
+	if( !model.Points.empty() ) {
+		output.Write( model.Points.data(), model.Points.size() * sizeof( C3DPoint ) );
+	}
+	for( auto triangle = model.Triangles.begin(); triangle != model.Triangles.end(); triangle++ ) {
+		output.WriteValue( static_cast<unsigned char>( 3 ) );
+		output.Write( &*triangle, sizeof( CTriangleIndex ) );
+	}
+	if( !model.Segments.empty() ) {
+		output.Write( model.Segments.data(), model.Segments.size() * sizeof( CSegmentIndex ) );
+	}
+	output.Close();
+}
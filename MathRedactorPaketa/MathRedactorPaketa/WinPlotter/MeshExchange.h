@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <string>
+#include "Model.h"
+
+/*
+* Импорт и экспорт моделей в форматах, понятных сторонним программам: OBJ (вершины, ломаные l и грани f),
+* двоичный STL (только треугольники) и двоичный PLY (вершины, грани и рёбра).
+* Файлы читаются и пишутся блоками через буфер, без строк на каждую строку файла. Большие OBJ разбираются
+* в несколько потоков: каждый блок делится по границам строк на части, которые разбираются параллельно.
+* Многоугольники разбиваются веером на треугольники, вырожденные отрезки и треугольники пропускаются.
+*/
+class CMeshExchange
+{
+public:
+	// Читает или пишет модель в формате, определяемом по расширению (.obj, .stl, .ply)
+	static void Read( const std::string& fileName, C3DModel& model );
+	static void Write( const C3DModel& model, const std::string& fileName );
+	// Поддерживается ли расширение файла
+	static bool IsSupported( const std::string& fileName );
+
+	// threadsCount - число потоков разбора, 0 - по числу ядер
+	static void ReadOBJ( const std::string& fileName, C3DModel& model, int threadsCount = 0 );
+	static void WriteOBJ( const C3DModel& model, const std::string& fileName );
+	// При чтении совпадающие вершины треугольников объединяются. Отрезки в STL не сохраняются
+	static void ReadSTL( const std::string& fileName, C3DModel& model );
+	static void WriteSTL( const C3DModel& model, const std::string& fileName );
+	static void ReadPLY( const std::string& fileName, C3DModel& model );
+	static void WritePLY( const C3DModel& model, const std::string& fileName );
+
+	// Исключение, возникающее, если файл не удалось открыть, прочитать или записать
+	class CannotOpen {};
+	// Исключение, возникающее при ошибке в содержимом файла или неизвестном расширении
+	class BadFormat {};
+};
@@ -0,0 +1,268 @@
+﻿#include "MeshFile.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert( sizeof( CMeshFileHeader ) == 64, "Mesh file header must be 64 bytes" );
+static_assert( sizeof( C3DPoint ) == 3 * sizeof( double ), "C3DPoint must match the point block layout" );
+static_assert( sizeof( CSegmentIndex ) == 2 * sizeof( int ), "CSegmentIndex must match the segment block layout" );
+static_assert( sizeof( CTriangleIndex ) == 3 * sizeof( int ), "CTriangleIndex must match the triangle block layout" );
+
+static const char MeshSignature[4] = { 'P', 'K', 'M', 'S' };
+
+// Смещение, выровненное на 8 байт вверх
+static unsigned long long alignBlock( unsigned long long offset )
+{
+	return ( offset + 7 ) & ~7ULL;
+}
+
+CMeshFile::CMeshFile() :
+#ifdef _WIN32
+	file( INVALID_HANDLE_VALUE ), mapping( 0 ),
+#else
+	file( -1 ),
+#endif
+	data( 0 ), size( 0 ), pointsCount( 0 ), segmentsCount( 0 ), trianglesCount( 0 ), coordinateSize( 0 ),
+	points( 0 ), segments( 0 ), triangles( 0 )
+{
+}
+
+CMeshFile::~CMeshFile()
+{
+	Close();
+}
+
+void CMeshFile::Open( const std::string& fileName )
+{
+	Close();
+#ifdef _WIN32
+	file = ::CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+	LARGE_INTEGER fileSize;
+	if( file == INVALID_HANDLE_VALUE || !::GetFileSizeEx( file, &fileSize ) ) {
+		Close();
+		throw CMeshFile::CannotOpen();
+	}
+	size = static_cast<size_t>( fileSize.QuadPart );
+	mapping = size > 0 ? ::CreateFileMappingA( file, 0, PAGE_READONLY, 0, 0, 0 ) : 0;
+	data = mapping != 0 ? static_cast<const char*>( ::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) ) : 0;
+#else
+	file = ::open( fileName.c_str(), O_RDONLY );
+	struct stat fileStat;
+	if( file < 0 || ::fstat( file, &fileStat ) != 0 ) {
+		Close();
+		throw CMeshFile::CannotOpen();
+	}
+	size = static_cast<size_t>( fileStat.st_size );
+	if( size > 0 ) {
+		void* view = ::mmap( 0, size, PROT_READ, MAP_SHARED, file, 0 );
+		data = view != MAP_FAILED ? static_cast<const char*>( view ) : 0;
+	}
+#endif
+	if( data == 0 ) {
+		Close();
+		throw CMeshFile::CannotOpen();
+	}
+
+	// Проверяем заголовок и то, что все блоки помещаются в файл. Сами данные не читаются
+	if( size < sizeof( CMeshFileHeader ) ) {
+		Close();
+		throw CMeshFile::BadFormat();
+	}
+	const CMeshFileHeader& header = *reinterpret_cast<const CMeshFileHeader*>( data );
+	if( std::memcmp( header.Signature, MeshSignature, sizeof( MeshSignature ) ) != 0 || header.Version != CurrentVersion ||
+		( header.CoordinateSize != sizeof( double ) && header.CoordinateSize != sizeof( float ) ) ||
+		header.PointsCount > INT_MAX || header.SegmentsCount > INT_MAX || header.TrianglesCount > INT_MAX )
+	{
+		Close();
+		throw CMeshFile::BadFormat();
+	}
+	coordinateSize = header.CoordinateSize;
+	points = getBlock( header.PointsOffset, header.PointsCount, 3 * coordinateSize );
+	segments = getBlock( header.SegmentsOffset, header.SegmentsCount, sizeof( CSegmentIndex ) );
+	triangles = getBlock( header.TrianglesOffset, header.TrianglesCount, sizeof( CTriangleIndex ) );
+	if( points == 0 || segments == 0 || triangles == 0 ) {
+		Close();
+		throw CMeshFile::BadFormat();
+	}
+	pointsCount = static_cast<int>( header.PointsCount );
+	segmentsCount = static_cast<int>( header.SegmentsCount );
+	trianglesCount = static_cast<int>( header.TrianglesCount );
+}
+
+void CMeshFile::Close()
+{
+#ifdef _WIN32
+	if( data != 0 ) {
+		::UnmapViewOfFile( data );
+	}
+	if( mapping != 0 ) {
+		::CloseHandle( mapping );
+	}
+	if( file != INVALID_HANDLE_VALUE ) {
+		::CloseHandle( file );
+	}
+	file = INVALID_HANDLE_VALUE;
+	mapping = 0;
+#else
+	if( data != 0 ) {
+		::munmap( const_cast<char*>( data ), size );
+	}
+	if( file >= 0 ) {
+		::close( file );
+	}
+	file = -1;
+#endif
+	data = 0;
+	size = 0;
+	pointsCount = 0;
+	segmentsCount = 0;
+	trianglesCount = 0;
+	coordinateSize = 0;
+	points = 0;
+	segments = 0;
+	triangles = 0;
+}
+
+const char* CMeshFile::getBlock( unsigned long long offset, unsigned long long count, size_t itemSize ) const
+{
+	// Пустой блок может стоять где угодно, непустой должен быть выровнен и не выходить за конец файла
+	if( count == 0 ) {
+		return data;
+	}
+	if( offset % 8 != 0 || offset < sizeof( CMeshFileHeader ) || offset > size || count > ( size - offset ) / itemSize ) {
+		return 0;
+	}
+	return data + offset;
+}
+
+const C3DPoint* CMeshFile::GetPoints() const
+{
+	return HasDoublePoints() ? reinterpret_cast<const C3DPoint*>( points ) : 0;
+}
+
+C3DPoint CMeshFile::GetPoint( int index ) const
+{
+	if( HasDoublePoints() ) {
+		return reinterpret_cast<const C3DPoint*>( points )[index];
+	}
+	const float* coordinates = reinterpret_cast<const float*>( points ) + 3 * index;
+	return C3DPoint( coordinates[0], coordinates[1], coordinates[2] );
+}
+
+const CSegmentIndex* CMeshFile::GetSegments() const
+{
+	return reinterpret_cast<const CSegmentIndex*>( segments );
+}
+
+const CTriangleIndex* CMeshFile::GetTriangles() const
+{
+	return reinterpret_cast<const CTriangleIndex*>( triangles );
+}
+
+void CMeshFile::CopyTo( C3DModel& model ) const
+{
+	const CSegmentIndex* segmentsBegin = GetSegments();
+	const CTriangleIndex* trianglesBegin = GetTriangles();
+	// Индексы проверяются до изменения модели, чтобы испорченный файл не оставил её наполовину заполненной
+	for( int i = 0; i < segmentsCount; i++ ) {
+		const CSegmentIndex& segment = segmentsBegin[i];
+		if( segment.First < 0 || segment.First >= pointsCount || segment.Second < 0 || segment.Second >= pointsCount ) {
+			throw CMeshFile::BadFormat();
+		}
+	}
+	for( int i = 0; i < trianglesCount; i++ ) {
+		const CTriangleIndex& triangle = trianglesBegin[i];
+		if( triangle.First < 0 || triangle.First >= pointsCount || triangle.Second < 0 || triangle.Second >= pointsCount ||
+			triangle.Third < 0 || triangle.Third >= pointsCount )
+		{
+			throw CMeshFile::BadFormat();
+		}
+	}
+
+	if( HasDoublePoints() ) {
+		model.Points.assign( GetPoints(), GetPoints() + pointsCount );
+	} else {
+		model.Points.resize( pointsCount );
+		for( int i = 0; i < pointsCount; i++ ) {
+			model.Points[i] = GetPoint( i );
+		}
+	}
+	model.Segments.assign( segmentsBegin, segmentsBegin + segmentsCount );
+	model.Triangles.assign( trianglesBegin, trianglesBegin + trianglesCount );
+}
+
+// Дописывает нули до выравнивания блока
+static void writePadding( std::ofstream& output, unsigned long long& offset )
+{
+	static const char zeros[8] = { 0 };
+	const unsigned long long aligned = alignBlock( offset );
+	output.write( zeros, static_cast<std::streamsize>( aligned - offset ) );
+	offset = aligned;
+}
+
+void CMeshFile::Save( const C3DModel& model, const std::string& fileName, bool singlePrecision )
+{
+	CMeshFileHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	std::memcpy( header.Signature, MeshSignature, sizeof( MeshSignature ) );
+	header.Version = CurrentVersion;
+	header.CoordinateSize = singlePrecision ? sizeof( float ) : sizeof( double );
+	header.PointsCount = model.Points.size();
+	header.SegmentsCount = model.Segments.size();
+	header.TrianglesCount = model.Triangles.size();
+	header.PointsOffset = sizeof( CMeshFileHeader );
+	header.SegmentsOffset = alignBlock( header.PointsOffset + header.PointsCount * 3 * header.CoordinateSize );
+	header.TrianglesOffset = alignBlock( header.SegmentsOffset + header.SegmentsCount * sizeof( CSegmentIndex ) );
+
+	std::ofstream output( fileName.c_str(), std::ofstream::binary | std::ofstream::trunc );
+	if( !output ) {
+		throw CMeshFile::CannotOpen();
+	}
+	output.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	unsigned long long offset = header.PointsOffset;
+	if( !singlePrecision ) {
+		if( !model.Points.empty() ) {
+			output.write( reinterpret_cast<const char*>( model.Points.data() ),
+				static_cast<std::streamsize>( model.Points.size() * sizeof( C3DPoint ) ) );
+		}
+	} else {
+		// Переводим точки во float блоками, чтобы не держать копию всей модели
+		const int BlockSize = 4096;
+		float block[3 * BlockSize];
+		for( size_t begin = 0; begin < model.Points.size(); begin += BlockSize ) {
+			const size_t count = std::min( static_cast<size_t>( BlockSize ), model.Points.size() - begin );
+			for( size_t i = 0; i < count; i++ ) {
+				const C3DPoint& point = model.Points[begin + i];
+				block[3 * i] = static_cast<float>( point.X );
+				block[3 * i + 1] = static_cast<float>( point.Y );
+				block[3 * i + 2] = static_cast<float>( point.Z );
+			}
+			output.write( reinterpret_cast<const char*>( block ), static_cast<std::streamsize>( 3 * count * sizeof( float ) ) );
+		}
+	}
+	offset += header.PointsCount * 3 * header.CoordinateSize;
+	writePadding( output, offset );
+	if( !model.Segments.empty() ) {
+		output.write( reinterpret_cast<const char*>( model.Segments.data() ),
+			static_cast<std::streamsize>( model.Segments.size() * sizeof( CSegmentIndex ) ) );
+	}
+	offset += header.SegmentsCount * sizeof( CSegmentIndex );
+	writePadding( output, offset );
+	if( !model.Triangles.empty() ) {
+		output.write( reinterpret_cast<const char*>( model.Triangles.data() ),
+			static_cast<std::streamsize>( model.Triangles.size() * sizeof( CTriangleIndex ) ) );
+	}
+	if( !output.flush() ) {
+		throw CMeshFile::CannotOpen();
+	}
+}
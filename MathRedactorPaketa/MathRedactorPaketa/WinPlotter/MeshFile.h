@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <string>
+#include "Model.h"
+
+/*
+* Двоичный формат сетки модели (.mesh). Файл состоит из заголовка и трёх блоков, каждый из которых выровнен
+* на 8 байт: координаты точек (по три double или float на точку), отрезки (по два int) и треугольники (по три int).
+* Блоки точек двойной точности, отрезков и треугольников совпадают по раскладке с C3DPoint, CSegmentIndex
+* и CTriangleIndex, поэтому отображённый в память файл читается без разбора. Порядок байт - little-endian.
+*/
+struct CMeshFileHeader {
+	// Сигнатура "PKMS"
+	char Signature[4];
+	// Версия формата
+	unsigned int Version;
+	// Размер одной координаты точки в байтах: 8 (double) или 4 (float)
+	unsigned int CoordinateSize;
+	unsigned int Reserved;
+	// Число элементов и смещения блоков от начала файла
+	unsigned long long PointsCount;
+	unsigned long long SegmentsCount;
+	unsigned long long TrianglesCount;
+	unsigned long long PointsOffset;
+	unsigned long long SegmentsOffset;
+	unsigned long long TrianglesOffset;
+};
+
+/*
+* Файл сетки, отображённый в память. Точки, отрезки и треугольники доступны прямо в отображении,
+* пока файл открыт; CopyTo переносит их в C3DModel блочным копированием.
+*/
+class CMeshFile
+{
+public:
+	static const unsigned int CurrentVersion = 1;
+
+	CMeshFile();
+	~CMeshFile();
+
+	// Отображает файл в память и проверяет заголовок
+	void Open( const std::string& fileName );
+	void Close();
+	bool IsOpen() const { return data != 0; }
+
+	int GetPointsCount() const { return pointsCount; }
+	int GetSegmentsCount() const { return segmentsCount; }
+	int GetTrianglesCount() const { return trianglesCount; }
+
+	// Хранятся ли точки с двойной точностью. Только в этом случае доступен GetPoints
+	bool HasDoublePoints() const { return coordinateSize == sizeof( double ); }
+	const C3DPoint* GetPoints() const;
+	// Точка с любой точностью хранения
+	C3DPoint GetPoint( int index ) const;
+	const CSegmentIndex* GetSegments() const;
+	const CTriangleIndex* GetTriangles() const;
+
+	// Заменяет содержимое модели содержимым файла. Индексы отрезков и треугольников проверяются
+	void CopyTo( C3DModel& model ) const;
+
+	// Сохраняет модель. С singlePrecision координаты записываются во float (файл почти вдвое меньше)
+	static void Save( const C3DModel& model, const std::string& fileName, bool singlePrecision = false );
+
+	// Исключение, возникающее, если файл не удалось открыть, отобразить в память или записать
+	class CannotOpen {};
+	// Исключение, возникающее при неверной сигнатуре, версии, размерах блоков или индексах
+	class BadFormat {};
+
+private:
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+	const char* data;
+	size_t size;
+	int pointsCount;
+	int segmentsCount;
+	int trianglesCount;
+	unsigned int coordinateSize;
+	const char* points;
+	const char* segments;
+	const char* triangles;
+
+	// Проверяет, что блок из count элементов размера itemSize по смещению offset целиком лежит в файле
+	const char* getBlock( unsigned long long offset, unsigned long long count, size_t itemSize ) const;
+
+	CMeshFile( const CMeshFile& );
+	void operator=( const CMeshFile& );
+};
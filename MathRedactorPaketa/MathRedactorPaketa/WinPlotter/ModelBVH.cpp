@@ -0,0 +1,158 @@
+﻿#include "ModelBVH.h"
+#include <algorithm>
+#include <limits>
+
+CBoundingBox::CBoundingBox() :
+Min( std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() ),
+Max( -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() )
+{
+}
+
+void CBoundingBox::Extend( const C3DPoint& point )
+{
+	Min = C3DPoint( std::min( Min.X, point.X ), std::min( Min.Y, point.Y ), std::min( Min.Z, point.Z ) );
+	Max = C3DPoint( std::max( Max.X, point.X ), std::max( Max.Y, point.Y ), std::max( Max.Z, point.Z ) );
+}
+
+void CBoundingBox::Extend( const CBoundingBox& other )
+{
+	if( !other.IsEmpty() ) {
+		Extend( other.Min );
+		Extend( other.Max );
+	}
+}
+
+C3DPoint CBoundingBox::Corner( int i ) const
+{
+	return C3DPoint( ( i & 1 ) ? Max.X : Min.X, ( i & 2 ) ? Max.Y : Min.Y, ( i & 4 ) ? Max.Z : Min.Z );
+}
+
+bool CBoundingBox::IsEmpty() const
+{
+	return Min.X > Max.X;
+}
+
+CModelBVH::CModelBVH() :
+modelPointsCount( 0 )
+{
+}
+
+void CModelBVH::Clear()
+{
+	nodes.clear();
+	points.clear();
+	segments.clear();
+	triangles.clear();
+	modelPointsCount = 0;
+}
+
+void CModelBVH::Build( const C3DModel& model )
+{
+	Clear();
+	modelPointsCount = static_cast<int>( model.Points.size() );
+
+	// Собираем все элементы модели вместе с их центрами
+	std::vector<CPrimitive> primitives;
+	primitives.reserve( model.Segments.size() + model.Triangles.size() );
+	for( int i = 0; i < static_cast<int>( model.Segments.size() ); i++ ) {
+		const CSegmentIndex& segment = model.Segments[i];
+		CPrimitive primitive = { false, i, ( model.Points[segment.First] + model.Points[segment.Second] ) / 2 };
+		primitives.push_back( primitive );
+	}
+	for( int i = 0; i < static_cast<int>( model.Triangles.size() ); i++ ) {
+		const CTriangleIndex& triangle = model.Triangles[i];
+		CPrimitive primitive = { true, i,
+			( model.Points[triangle.First] + model.Points[triangle.Second] + model.Points[triangle.Third] ) / 3 };
+		primitives.push_back( primitive );
+	}
+	if( primitives.empty() ) {
+		return;
+	}
+
+	segments.reserve( model.Segments.size() );
+	triangles.reserve( model.Triangles.size() );
+	pointMarks.assign( model.Points.size(), -1 );
+	build( model, primitives, 0, static_cast<int>( primitives.size() ) );
+	pointMarks.clear();
+}
+
+int CModelBVH::build( const C3DModel& model, std::vector<CPrimitive>& primitives, int begin, int end )
+{
+	const int nodeIndex = static_cast<int>( nodes.size() );
+	nodes.push_back( CNode() );
+	CNode node;
+	node.Left = node.Right = -1;
+	node.SegmentsBegin = static_cast<int>( segments.size() );
+	node.TrianglesBegin = static_cast<int>( triangles.size() );
+
+	if( end - begin <= LeafSize ) {
+		// Лист: копируем его элементы и собираем используемые ими точки без повторов
+		node.PointsBegin = static_cast<int>( points.size() );
+		for( int i = begin; i < end; i++ ) {
+			int vertices[3];
+			int verticesCount;
+			if( primitives[i].IsTriangle ) {
+				const CTriangleIndex& triangle = model.Triangles[primitives[i].Index];
+				triangles.push_back( triangle );
+				vertices[0] = triangle.First;
+				vertices[1] = triangle.Second;
+				vertices[2] = triangle.Third;
+				verticesCount = 3;
+			} else {
+				const CSegmentIndex& segment = model.Segments[primitives[i].Index];
+				segments.push_back( segment );
+				vertices[0] = segment.First;
+				vertices[1] = segment.Second;
+				verticesCount = 2;
+			}
+			for( int j = 0; j < verticesCount; j++ ) {
+				if( pointMarks[vertices[j]] != nodeIndex ) {
+					pointMarks[vertices[j]] = nodeIndex;
+					points.push_back( vertices[j] );
+					node.Bounds.Extend( model.Points[vertices[j]] );
+				}
+			}
+		}
+	} else {
+		// Делим элементы пополам по медиане центров вдоль самой длинной стороны
+		CBoundingBox centers;
+		for( int i = begin; i < end; i++ ) {
+			centers.Extend( primitives[i].Center );
+		}
+		const C3DPoint size = centers.Max - centers.Min;
+		const int axis = size.X >= size.Y && size.X >= size.Z ? 0 : ( size.Y >= size.Z ? 1 : 2 );
+		const int middle = begin + ( end - begin ) / 2;
+		std::nth_element( primitives.begin() + begin, primitives.begin() + middle, primitives.begin() + end,
+			[axis]( const CPrimitive& first, const CPrimitive& second ) {
+				const double firstValue = axis == 0 ? first.Center.X : ( axis == 1 ? first.Center.Y : first.Center.Z );
+				const double secondValue = axis == 0 ? second.Center.X : ( axis == 1 ? second.Center.Y : second.Center.Z );
+				return firstValue < secondValue;
+			} );
+
+		node.Left = build( model, primitives, begin, middle );
+		node.Right = build( model, primitives, middle, end );
+		node.Bounds.Extend( nodes[node.Left].Bounds );
+		node.Bounds.Extend( nodes[node.Right].Bounds );
+
+		// Точки поддерева без повторов: общие вершины соседних листьев попадают в список один раз,
+		// поэтому при проецировании узла каждая точка пишется ровно одним потоком
+		node.PointsBegin = static_cast<int>( points.size() );
+		const int children[2] = { node.Left, node.Right };
+		for( int i = 0; i < 2; i++ ) {
+			const CNode& child = nodes[children[i]];
+			for( int j = child.PointsBegin; j < child.PointsEnd; j++ ) {
+				const int point = points[j];
+				if( pointMarks[point] != nodeIndex ) {
+					pointMarks[point] = nodeIndex;
+					points.push_back( point );
+				}
+			}
+		}
+	}
+
+	node.PointsEnd = static_cast<int>( points.size() );
+	node.SegmentsEnd = static_cast<int>( segments.size() );
+	node.TrianglesEnd = static_cast<int>( triangles.size() );
+	nodes[nodeIndex] = node;
+	return nodeIndex;
+}
@@ -0,0 +1,89 @@
+﻿#pragma once
+#include <vector>
+#include "3DPoint.h"
+#include "Model.h"
+
+// Ограничивающий параллелепипед, стороны которого параллельны осям координат
+struct CBoundingBox
+{
+	C3DPoint Min, Max;
+
+	CBoundingBox();
+
+	// Расширяет параллелепипед так, чтобы он содержал точку
+	void Extend( const C3DPoint& point );
+	// Расширяет параллелепипед так, чтобы он содержал другой параллелепипед
+	void Extend( const CBoundingBox& other );
+	// Возвращает i-ю вершину параллелепипеда (0 <= i < 8)
+	C3DPoint Corner( int i ) const;
+	// Пуст ли параллелепипед (не было добавлено ни одной точки)
+	bool IsEmpty() const;
+};
+
+/*
+* Иерархия ограничивающих объёмов для трёхмерной модели. Элементы модели (отрезки и треугольники) разбиваются
+* на пространственно компактные блоки, блоки объединяются в двоичное дерево. Это позволяет движку принимать
+* или отбрасывать целые части модели одной проверкой.
+* Данные листьев хранятся в порядке обхода дерева в глубину, поэтому элементы любого поддерева лежат подряд.
+* Точки так лечь не могут (общие вершины соседних листьев), поэтому у каждого узла свой список точек.
+*/
+class CModelBVH
+{
+public:
+	// Узел дерева. Диапазоны [begin, end) указывают на элементы всего поддерева
+	struct CNode {
+		CBoundingBox Bounds;
+		// Номера дочерних узлов (-1 у листьев)
+		int Left, Right;
+		// Номера точек модели, используемых элементами поддерева, без повторов
+		int PointsBegin, PointsEnd;
+		// Отрезки и треугольники поддерева
+		int SegmentsBegin, SegmentsEnd;
+		int TrianglesBegin, TrianglesEnd;
+
+		bool IsLeaf() const { return Left < 0; }
+	};
+
+	CModelBVH();
+
+	// Строит иерархию по модели. Должна вызываться заново при каждом изменении модели
+	void Build( const C3DModel& model );
+
+	// Очищает иерархию
+	void Clear();
+
+	// Узлы дерева, корень имеет номер 0
+	const std::vector<CNode>& GetNodes() const { return nodes; }
+	// Номера точек модели: списки листьев, а после потомков каждого внутреннего узла - объединение их списков.
+	// Внутри одного узла точки не повторяются, но точка может встречаться в нескольких узлах
+	const std::vector<int>& GetPoints() const { return points; }
+	// Отрезки и треугольники, сгруппированные по листьям
+	const std::vector<CSegmentIndex>& GetSegments() const { return segments; }
+	const std::vector<CTriangleIndex>& GetTriangles() const { return triangles; }
+
+	// Количество точек модели, по которой построена иерархия
+	int GetModelPointsCount() const { return modelPointsCount; }
+
+	// Максимальное количество элементов в листе
+	static const int LeafSize = 512;
+
+private:
+	// Элемент модели при построении: его вид, номер и центр
+	struct CPrimitive {
+		bool IsTriangle;
+		int Index;
+		C3DPoint Center;
+	};
+
+	std::vector<CNode> nodes;
+	std::vector<int> points;
+	std::vector<CSegmentIndex> segments;
+	std::vector<CTriangleIndex> triangles;
+	int modelPointsCount;
+
+	// Вспомогательная отметка для устранения повторов точек внутри узла
+	std::vector<int> pointMarks;
+
+	// Рекурсивно строит поддерево для элементов [begin, end) и возвращает номер его корня
+	int build( const C3DModel& model, std::vector<CPrimitive>& primitives, int begin, int end );
+};
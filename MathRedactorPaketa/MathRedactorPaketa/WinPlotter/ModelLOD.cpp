@@ -0,0 +1,51 @@
+﻿#include "ModelLOD.h"
+#include <cmath>
+
+void CModelLOD::Clear()
+{
+	levels.clear();
+}
+
+void CModelLOD::AddLevel( const C3DModel& model )
+{
+	CLevel level;
+	level.Model = &model;
+	level.Hierarchy.Build( model );
+
+	// Отрезки с точками вне области определения формулы в среднюю длину не входят
+	double lengthsSum = 0;
+	int segmentsCount = 0;
+	for( auto segment = model.Segments.begin(); segment != model.Segments.end(); segment++ ) {
+		const double length = ( model.Points[segment->Second] - model.Points[segment->First] ).length();
+		if( std::isfinite( length ) ) {
+			lengthsSum += length;
+			segmentsCount++;
+		}
+	}
+	level.EdgeLength = segmentsCount > 0 ? lengthsSum / segmentsCount : 0;
+
+	levels.push_back( level );
+}
+
+const C3DModel& CModelLOD::GetModel( int level ) const
+{
+	return *getLevel( level ).Model;
+}
+
+const CModelBVH& CModelLOD::GetHierarchy( int level ) const
+{
+	return getLevel( level ).Hierarchy;
+}
+
+double CModelLOD::GetEdgeLength( int level ) const
+{
+	return getLevel( level ).EdgeLength;
+}
+
+const CModelLOD::CLevel& CModelLOD::getLevel( int level ) const
+{
+	if( level < 0 || level >= GetLevelsCount() ) {
+		throw CModelLOD::OutOfRange();
+	}
+	return levels[level];
+}
@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <vector>
+#include "Model.h"
+#include "ModelBVH.h"
+
+/*
+* Пирамида уровней детализации модели. Уровень 0 - исходная модель, каждый следующий - её прореженная копия
+* (например, сетка графика, в которой взята каждая 2-я, 4-я, ... точка по каждой оси).
+* Пирамида не владеет моделями уровней, но хранит для каждого из них иерархию ограничивающих объёмов
+* и среднюю длину отрезка, по которой движок выбирает уровень.
+*/
+class CModelLOD
+{
+public:
+	// Удаляет все уровни
+	void Clear();
+
+	// Добавляет следующий, более грубый уровень. Модель должна существовать, пока используется пирамида
+	void AddLevel( const C3DModel& model );
+
+	int GetLevelsCount() const { return static_cast<int>( levels.size() ); }
+	const C3DModel& GetModel( int level ) const;
+	const CModelBVH& GetHierarchy( int level ) const;
+	// Средняя длина отрезка уровня в пространстве графика
+	double GetEdgeLength( int level ) const;
+
+	// Исключение, возникающее при обращении к несуществующему уровню
+	class OutOfRange {};
+
+private:
+	struct CLevel {
+		const C3DModel* Model;
+		CModelBVH Hierarchy;
+		double EdgeLength;
+	};
+	std::vector<CLevel> levels;
+
+	const CLevel& getLevel( int level ) const;
+};
@@ -3,6 +3,7 @@
 #include "Operators.h"
 
 #include <assert.h>
+#include <cmath>
 
 // CConst
 
@@ -0,0 +1,43 @@
+﻿#include "RenderStatistics.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <chrono>
+#endif
+
+CRenderStatistics::CRenderStatistics()
+{
+	Reset();
+}
+
+void CRenderStatistics::Reset()
+{
+	TransformTime = 0;
+	FilterTime = 0;
+	MergeTime = 0;
+	RenderTime = 0;
+	InputPoints = 0;
+	InputSegments = 0;
+	InputTriangles = 0;
+	ProjectedPoints = 0;
+	CulledPoints = 0;
+	RenderedSegments = 0;
+	RenderedTriangles = 0;
+	MergedSegments = 0;
+}
+
+double CStopwatch::Now()
+{
+#ifdef _WIN32
+	// Часы из std::chrono в VS2013 имеют точность системного таймера, поэтому используем счётчик производительности
+	static LARGE_INTEGER frequency = { 0 };
+	if( frequency.QuadPart == 0 ) {
+		::QueryPerformanceFrequency( &frequency );
+	}
+	LARGE_INTEGER counter;
+	::QueryPerformanceCounter( &counter );
+	return 1000.0 * static_cast<double>( counter.QuadPart ) / static_cast<double>( frequency.QuadPart );
+#else
+	return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+
+// Время стадий и счётчики последнего кадра, отрисованного движком
+struct CRenderStatistics
+{
+	// Время стадий в миллисекундах: перевод точек в систему камеры с проецированием, отсечение (включая обход
+	// иерархии и выбор уровня детализации), объединение коротких отрезков и весь вызов Render
+	double TransformTime;
+	double FilterTime;
+	double MergeTime;
+	double RenderTime;
+
+	// Элементы моделей, поступившие на вход
+	int InputPoints;
+	int InputSegments;
+	int InputTriangles;
+	// Точки, переведённые в систему камеры, и те из них, что оказались вне области видимости
+	int ProjectedPoints;
+	int CulledPoints;
+	// Элементы на выходе движка и отрезки, убранные при объединении
+	int RenderedSegments;
+	int RenderedTriangles;
+	int MergedSegments;
+
+	CRenderStatistics();
+
+	// Обнуляет время и счётчики
+	void Reset();
+};
+
+// Таймер для замера стадий отрисовки
+class CStopwatch
+{
+public:
+	// Текущее время в миллисекундах от произвольного начала отсчёта
+	static double Now();
+};
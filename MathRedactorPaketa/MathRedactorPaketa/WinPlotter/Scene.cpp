@@ -0,0 +1,47 @@
+﻿#include "Scene.h"
+
+CSceneObject::CSceneObject( const C3DModel* model, const CModelBVH* hierarchy, const CModelLOD* levels, unsigned int color ) :
+	Model( model ), Hierarchy( hierarchy ), Levels( levels ), Color( color ), Visible( true )
+{
+}
+
+int CScene::AddObject( const C3DModel& model, unsigned int color, const CModelBVH* hierarchy )
+{
+	objects.push_back( CSceneObject( &model, hierarchy, 0, color ) );
+	return static_cast<int>( objects.size() ) - 1;
+}
+
+int CScene::AddObject( const CModelLOD& levels, unsigned int color )
+{
+	objects.push_back( CSceneObject( 0, 0, &levels, color ) );
+	return static_cast<int>( objects.size() ) - 1;
+}
+
+void CScene::SetVisible( int index, bool visible )
+{
+	if( index < 0 || index >= GetObjectsCount() ) {
+		throw CScene::OutOfRange();
+	}
+	objects[index].Visible = visible;
+}
+
+void CScene::SetColor( int index, unsigned int color )
+{
+	if( index < 0 || index >= GetObjectsCount() ) {
+		throw CScene::OutOfRange();
+	}
+	objects[index].Color = color;
+}
+
+const CSceneObject& CScene::GetObjectAt( int index ) const
+{
+	if( index < 0 || index >= GetObjectsCount() ) {
+		throw CScene::OutOfRange();
+	}
+	return objects[index];
+}
+
+void CScene::Clear()
+{
+	objects.clear();
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <vector>
+#include "Model.h"
+#include "ModelBVH.h"
+#include "ModelLOD.h"
+
+// Объект сцены: модель и параметры её отображения. Сцена не владеет моделями, иерархиями и пирамидами
+struct CSceneObject
+{
+	const C3DModel* Model;
+	// Иерархия ограничивающих объёмов модели или 0, если модель отсекается поэлементно
+	const CModelBVH* Hierarchy;
+	// Пирамида уровней детализации или 0. Если задана, движок сам выбирает уровень, а Model и Hierarchy не используются
+	const CModelLOD* Levels;
+	// Цвет элементов модели в формате макроса RGB из WinAPI
+	unsigned int Color;
+	// Рисуется ли модель
+	bool Visible;
+
+	CSceneObject( const C3DModel* model, const CModelBVH* hierarchy, const CModelLOD* levels, unsigned int color );
+};
+
+/*
+* Набор моделей, которые движок отрисовывает за один проход: общая подготовка матрицы и плоскостей отсечения,
+* один выходной поток примитивов
+*/
+class CScene
+{
+public:
+	// Добавляет модель в сцену, возвращает номер объекта
+	int AddObject( const C3DModel& model, unsigned int color, const CModelBVH* hierarchy = 0 );
+	// Добавляет модель, заданную пирамидой уровней детализации
+	int AddObject( const CModelLOD& levels, unsigned int color );
+
+	// Меняет параметры отображения объекта
+	void SetVisible( int index, bool visible );
+	void SetColor( int index, unsigned int color );
+
+	int GetObjectsCount() const { return static_cast<int>( objects.size() ); }
+	// Возвращает объект по номеру (имя GetObject занято макросом WinAPI)
+	const CSceneObject& GetObjectAt( int index ) const;
+
+	// Удаляет все объекты сцены
+	void Clear();
+
+	// Исключение, возникающее при обращении к несуществующему объекту
+	class OutOfRange {};
+
+private:
+	std::vector<CSceneObject> objects;
+};
+
+// Диапазон элементов отрисованной сцены, относящихся к одному объекту
+struct CRenderedSceneObject
+{
+	// Номер объекта в сцене
+	int Index;
+	unsigned int Color;
+	int SegmentsBegin, SegmentsEnd;
+	int TrianglesBegin, TrianglesEnd;
+};
+
+// Результат отрисовки сцены: общая двухмерная модель и диапазоны её элементов для каждого видимого объекта
+struct CRenderedScene
+{
+	C2DModel Model;
+	std::vector<CRenderedSceneObject> Objects;
+};
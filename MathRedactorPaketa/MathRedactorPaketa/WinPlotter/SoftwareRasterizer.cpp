@@ -0,0 +1,300 @@
+﻿#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+CSoftwareRasterizer::CSoftwareRasterizer( int width_, int height_, int threadsCount_ ) :
+width( 0 ), height( 0 ), threadsCount( threadsCount_ ), tilesX( 0 ), tilesY( 0 ), model( 0 ), depths( 0 ),
+lineColor( 0 ), fillColor( 0 )
+{
+	if( threadsCount <= 0 ) {
+		threadsCount = std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) );
+	}
+	SetSize( width_, height_ );
+}
+
+unsigned int CSoftwareRasterizer::MakeColor( unsigned char red, unsigned char green, unsigned char blue, unsigned char alpha )
+{
+	return static_cast<unsigned int>( red ) | static_cast<unsigned int>( green ) << 8 |
+		static_cast<unsigned int>( blue ) << 16 | static_cast<unsigned int>( alpha ) << 24;
+}
+
+void CSoftwareRasterizer::SetSize( int width_, int height_ )
+{
+	if( width_ <= 0 || height_ <= 0 ) {
+		throw CSoftwareRasterizer::IncorrectSize();
+	}
+	width = width_;
+	height = height_;
+	pixels.resize( width * height );
+	depthBuffer.resize( width * height );
+
+	tilesX = ( width + TileSize - 1 ) / TileSize;
+	tilesY = ( height + TileSize - 1 ) / TileSize;
+	tileSegments.resize( tilesX * tilesY );
+	tileTriangles.resize( tilesX * tilesY );
+}
+
+void CSoftwareRasterizer::Clear( unsigned int color )
+{
+	std::fill( pixels.begin(), pixels.end(), color );
+	std::fill( depthBuffer.begin(), depthBuffer.end(), std::numeric_limits<float>::max() );
+}
+
+void CSoftwareRasterizer::Draw( const C2DModel& model_, const std::vector<double>& depths_, unsigned int lineColor_,
+	unsigned int fillColor_ )
+{
+	model = &model_;
+	depths = depths_.empty() ? 0 : &depths_;
+	lineColor = lineColor_;
+	fillColor = fillColor_;
+
+	binPrimitives();
+
+	// Потоки разбирают плитки по очереди; плитки не пересекаются, поэтому синхронизация записи не нужна
+	const int tilesCount = tilesX * tilesY;
+	std::atomic<int> nextTile( 0 );
+	auto worker = [this, &nextTile, tilesCount]() {
+		for( int tile = nextTile++; tile < tilesCount; tile = nextTile++ ) {
+			drawTile( tile );
+		}
+	};
+	const int workersCount = std::min( threadsCount, tilesCount );
+	std::vector<std::thread> workers;
+	for( int i = 1; i < workersCount; i++ ) {
+		workers.push_back( std::thread( worker ) );
+	}
+	worker();
+	for( auto thread = workers.begin(); thread != workers.end(); thread++ ) {
+		thread->join();
+	}
+
+	model = 0;
+	depths = 0;
+}
+
+void CSoftwareRasterizer::binPrimitives()
+{
+	for( int i = 0; i < tilesX * tilesY; i++ ) {
+		tileSegments[i].clear();
+		tileTriangles[i].clear();
+	}
+
+	const std::vector<C2DPoint>& points = model->Points;
+	for( int i = 0; i < static_cast<int>( model->Segments.size() ); i++ ) {
+		const C2DPoint& first = points[model->Segments[i].First];
+		const C2DPoint& second = points[model->Segments[i].Second];
+		// Сглаженная линия задевает по пикселю с каждой стороны
+		binRectangle( std::min( first.X, second.X ) - 1, std::min( first.Y, second.Y ) - 1,
+			std::max( first.X, second.X ) + 1, std::max( first.Y, second.Y ) + 1, i, tileSegments );
+	}
+	for( int i = 0; i < static_cast<int>( model->Triangles.size() ); i++ ) {
+		const C2DPoint& first = points[model->Triangles[i].First];
+		const C2DPoint& second = points[model->Triangles[i].Second];
+		const C2DPoint& third = points[model->Triangles[i].Third];
+		binRectangle( std::min( first.X, std::min( second.X, third.X ) ), std::min( first.Y, std::min( second.Y, third.Y ) ),
+			std::max( first.X, std::max( second.X, third.X ) ), std::max( first.Y, std::max( second.Y, third.Y ) ),
+			i, tileTriangles );
+	}
+}
+
+void CSoftwareRasterizer::binRectangle( double minX, double minY, double maxX, double maxY, int index,
+	std::vector< std::vector<int> >& bins )
+{
+	if( !( maxX >= 0 && maxY >= 0 && minX < width && minY < height ) ) {
+		// Прямоугольник вне экрана (или координаты не являются числами)
+		return;
+	}
+	const int firstX = static_cast<int>( std::max( 0.0, minX ) ) / TileSize;
+	const int firstY = static_cast<int>( std::max( 0.0, minY ) ) / TileSize;
+	const int lastX = static_cast<int>( std::min( width - 1.0, maxX ) ) / TileSize;
+	const int lastY = static_cast<int>( std::min( height - 1.0, maxY ) ) / TileSize;
+	for( int y = firstY; y <= lastY; y++ ) {
+		for( int x = firstX; x <= lastX; x++ ) {
+			bins[y * tilesX + x].push_back( index );
+		}
+	}
+}
+
+void CSoftwareRasterizer::drawTile( int tile )
+{
+	const int left = ( tile % tilesX ) * TileSize;
+	const int top = ( tile / tilesX ) * TileSize;
+	const int right = std::min( left + TileSize, width );
+	const int bottom = std::min( top + TileSize, height );
+
+	const std::vector<int>& triangles = tileTriangles[tile];
+	for( auto triangle = triangles.begin(); triangle != triangles.end(); triangle++ ) {
+		fillTriangle( *triangle, left, top, right, bottom );
+	}
+	const std::vector<int>& segments = tileSegments[tile];
+	for( auto segment = segments.begin(); segment != segments.end(); segment++ ) {
+		drawLine( *segment, left, top, right, bottom );
+	}
+}
+
+double CSoftwareRasterizer::pointDepth( int index ) const
+{
+	return depths == 0 ? 1 : ( *depths )[index];
+}
+
+void CSoftwareRasterizer::fillTriangle( int index, int left, int top, int right, int bottom )
+{
+	const CTriangleIndex& triangle = model->Triangles[index];
+	const C2DPoint* vertices[3] = {
+		&model->Points[triangle.First], &model->Points[triangle.Second], &model->Points[triangle.Third]
+	};
+	// Обратные глубины линейно интерполируются в экранных координатах
+	double inverseDepths[3] = {
+		1 / pointDepth( triangle.First ), 1 / pointDepth( triangle.Second ), 1 / pointDepth( triangle.Third )
+	};
+
+	double area = ( vertices[1]->X - vertices[0]->X ) * ( vertices[2]->Y - vertices[0]->Y ) -
+		( vertices[1]->Y - vertices[0]->Y ) * ( vertices[2]->X - vertices[0]->X );
+	if( area == 0 || area != area ) {
+		return;
+	}
+	// Приводим обход вершин к одному направлению
+	if( area < 0 ) {
+		std::swap( vertices[1], vertices[2] );
+		std::swap( inverseDepths[1], inverseDepths[2] );
+		area = -area;
+	}
+
+	// Пиксель с координатами (x, y) имеет центр в точке (x, y), как и проекция CEngineCamera.
+	// Границы сначала ограничиваются плиткой, и только потом приводятся к int, чтобы не переполниться
+	const int minX = static_cast<int>( std::max<double>( left,
+		std::ceil( std::min( vertices[0]->X, std::min( vertices[1]->X, vertices[2]->X ) ) ) ) );
+	const int minY = static_cast<int>( std::max<double>( top,
+		std::ceil( std::min( vertices[0]->Y, std::min( vertices[1]->Y, vertices[2]->Y ) ) ) ) );
+	const int maxX = static_cast<int>( std::min<double>( right - 1,
+		std::floor( std::max( vertices[0]->X, std::max( vertices[1]->X, vertices[2]->X ) ) ) ) );
+	const int maxY = static_cast<int>( std::min<double>( bottom - 1,
+		std::floor( std::max( vertices[0]->Y, std::max( vertices[1]->Y, vertices[2]->Y ) ) ) ) );
+
+	for( int y = minY; y <= maxY; y++ ) {
+		for( int x = minX; x <= maxX; x++ ) {
+			// Барицентрические координаты пикселя через функции рёбер
+			double weights[3];
+			bool inside = true;
+			for( int i = 0; i < 3 && inside; i++ ) {
+				const C2DPoint& from = *vertices[( i + 1 ) % 3];
+				const C2DPoint& to = *vertices[( i + 2 ) % 3];
+				weights[i] = ( to.X - from.X ) * ( y - from.Y ) - ( to.Y - from.Y ) * ( x - from.X );
+				// Пиксели на общем ребре соседних треугольников закрашиваются только одним из них
+				// (правило верхнего левого ребра)
+				const bool topLeft = ( to.Y == from.Y && to.X > from.X ) || to.Y < from.Y;
+				inside = weights[i] > 0 || ( weights[i] == 0 && topLeft );
+			}
+			if( !inside ) {
+				continue;
+			}
+			const double inverseDepth = ( weights[0] * inverseDepths[0] + weights[1] * inverseDepths[1] +
+				weights[2] * inverseDepths[2] ) / area;
+			const float depth = static_cast<float>( 1 / inverseDepth );
+			float& storedDepth = depthBuffer[y * width + x];
+			if( depth <= storedDepth ) {
+				storedDepth = depth;
+				pixels[y * width + x] = fillColor;
+			}
+		}
+	}
+}
+
+void CSoftwareRasterizer::drawLine( int index, int left, int top, int right, int bottom )
+{
+	const CSegmentIndex& segment = model->Segments[index];
+	double x0 = model->Points[segment.First].X;
+	double y0 = model->Points[segment.First].Y;
+	double x1 = model->Points[segment.Second].X;
+	double y1 = model->Points[segment.Second].Y;
+	double z0 = 1 / pointDepth( segment.First );
+	double z1 = 1 / pointDepth( segment.Second );
+
+	// Алгоритм Ву: идём вдоль главной оси и на каждом шаге закрашиваем два соседних пикселя поперёк неё
+	const bool steep = std::abs( y1 - y0 ) > std::abs( x1 - x0 );
+	if( steep ) {
+		std::swap( x0, y0 );
+		std::swap( x1, y1 );
+	}
+	if( x0 > x1 ) {
+		std::swap( x0, x1 );
+		std::swap( y0, y1 );
+		std::swap( z0, z1 );
+	}
+	const double dx = x1 - x0;
+	const double gradient = dx == 0 ? 1 : ( y1 - y0 ) / dx;
+	const double depthGradient = dx == 0 ? 0 : ( z1 - z0 ) / dx;
+
+	// Границы плитки вдоль главной и поперечной осей
+	const int majorBegin = steep ? top : left;
+	const int majorEnd = steep ? bottom : right;
+	const int minorBegin = steep ? left : top;
+	const int minorEnd = steep ? right : bottom;
+
+	// Координаты проверяются до приведения к int, так как концы отрезка могут быть далеко за экраном
+	auto plot = [&]( double major, double minor, double coverage ) {
+		if( major < majorBegin || major >= majorEnd || minor < minorBegin || minor >= minorEnd || coverage <= 0 ) {
+			return;
+		}
+		const double depth = 1 / ( z0 + depthGradient * ( major - x0 ) );
+		if( steep ) {
+			blendPixel( static_cast<int>( minor ), static_cast<int>( major ), depth, lineColor, coverage );
+		} else {
+			blendPixel( static_cast<int>( major ), static_cast<int>( minor ), depth, lineColor, coverage );
+		}
+	};
+
+	// Концы отрезка закрашиваются с учётом того, какая часть пикселя ими покрыта
+	const double firstEnd = std::floor( x0 + 0.5 );
+	const double firstY = y0 + gradient * ( firstEnd - x0 );
+	const double firstGap = 1 - ( x0 + 0.5 - std::floor( x0 + 0.5 ) );
+	const double secondEnd = std::floor( x1 + 0.5 );
+	const double secondY = y1 + gradient * ( secondEnd - x1 );
+	const double secondGap = x1 + 0.5 - std::floor( x1 + 0.5 );
+
+	// Отрезок целиком вне плитки по главной оси
+	if( secondEnd < majorBegin || firstEnd >= majorEnd ) {
+		return;
+	}
+
+	double fraction = firstY - std::floor( firstY );
+	plot( firstEnd, std::floor( firstY ), ( 1 - fraction ) * firstGap );
+	plot( firstEnd, std::floor( firstY ) + 1, fraction * firstGap );
+	if( secondEnd != firstEnd ) {
+		fraction = secondY - std::floor( secondY );
+		plot( secondEnd, std::floor( secondY ), ( 1 - fraction ) * secondGap );
+		plot( secondEnd, std::floor( secondY ) + 1, fraction * secondGap );
+	}
+
+	// Внутренние пиксели: проходим только ту часть, которая попадает в плитку
+	const int begin = static_cast<int>( std::max<double>( firstEnd + 1, majorBegin ) );
+	const int end = static_cast<int>( std::min<double>( secondEnd - 1, majorEnd - 1 ) );
+	for( int major = begin; major <= end; major++ ) {
+		const double minor = firstY + gradient * ( major - firstEnd );
+		const double floorMinor = std::floor( minor );
+		fraction = minor - floorMinor;
+		plot( major, floorMinor, 1 - fraction );
+		plot( major, floorMinor + 1, fraction );
+	}
+}
+
+void CSoftwareRasterizer::blendPixel( int x, int y, double depth, unsigned int color, double coverage )
+{
+	const int offset = y * width + x;
+	// Небольшой допуск, чтобы рёбра треугольников не закрывали совпадающие с ними отрезки
+	if( depth > depthBuffer[offset] * ( 1 + 1e-5 ) ) {
+		return;
+	}
+	const double alpha = std::min( 1.0, coverage ) * ( ( color >> 24 ) & 0xFF ) / 255;
+	unsigned int& pixel = pixels[offset];
+	unsigned int result = pixel & 0xFF000000;
+	for( int shift = 0; shift < 24; shift += 8 ) {
+		const double source = ( color >> shift ) & 0xFF;
+		const double destination = ( pixel >> shift ) & 0xFF;
+		result |= static_cast<unsigned int>( destination + ( source - destination ) * alpha + 0.5 ) << shift;
+	}
+	pixel = result;
+}
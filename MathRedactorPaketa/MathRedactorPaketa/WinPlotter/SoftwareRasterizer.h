@@ -0,0 +1,77 @@
+﻿#pragma once
+#include <vector>
+#include "Model.h"
+
+/*
+* Программный растеризатор: рисует двухмерную модель, полученную от CEngineCamera, в буфер пикселей в памяти.
+* Отрезки рисуются со сглаживанием (алгоритм Ву), треугольники заливаются. Для перекрытия используется буфер глубины.
+* Экран делится на квадратные плитки, которые растеризуются параллельно: каждый поток пишет только в свои плитки.
+* Не зависит от WinAPI, поэтому может использоваться без окна.
+*/
+class CSoftwareRasterizer
+{
+public:
+	// threadsCount = 0 означает число ядер процессора
+	CSoftwareRasterizer( int width = 640, int height = 480, int threadsCount = 0 );
+
+	// Устанавливает размеры буфера (содержимое буфера при этом не определено до вызова Clear)
+	void SetSize( int width, int height );
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
+
+	// Заливает буфер цветом и сбрасывает буфер глубины
+	void Clear( unsigned int color );
+
+	// Рисует модель поверх текущего содержимого буфера. depths - глубины точек модели (CEngineCamera::GetDepths),
+	// если массив пуст, проверка глубины не выполняется. Сначала рисуются треугольники, затем отрезки
+	void Draw( const C2DModel& model, const std::vector<double>& depths, unsigned int lineColor, unsigned int fillColor );
+
+	// Пиксели построчно, каждый в формате MakeColor
+	const std::vector<unsigned int>& GetPixels() const { return pixels; }
+
+	// Собирает цвет пикселя: в памяти байты идут в порядке R, G, B, A
+	static unsigned int MakeColor( unsigned char red, unsigned char green, unsigned char blue, unsigned char alpha = 255 );
+
+	// Размер стороны плитки в пикселях
+	static const int TileSize = 64;
+
+	// Исключение, вызываемое при неверно переданных размерах буфера
+	class IncorrectSize {};
+
+private:
+	int width, height;
+	int threadsCount;
+
+	// Цвета пикселей и глубины (координата Z в системе камеры)
+	std::vector<unsigned int> pixels;
+	std::vector<float> depthBuffer;
+
+	// Количество плиток по горизонтали и вертикали
+	int tilesX, tilesY;
+	// Номера отрезков и треугольников, задевающих каждую из плиток (буферы переиспользуются между вызовами)
+	std::vector< std::vector<int> > tileSegments;
+	std::vector< std::vector<int> > tileTriangles;
+
+	// Параметры текущего вызова Draw
+	const C2DModel* model;
+	const std::vector<double>* depths;
+	unsigned int lineColor, fillColor;
+
+	// Распределяет элементы модели по плиткам, которые задевают их ограничивающие прямоугольники
+	void binPrimitives();
+	void binRectangle( double minX, double minY, double maxX, double maxY, int index, std::vector< std::vector<int> >& bins );
+
+	// Рисует все элементы одной плитки
+	void drawTile( int tile );
+
+	// Заливает треугольник в пределах прямоугольника плитки [left, right) x [top, bottom)
+	void fillTriangle( int index, int left, int top, int right, int bottom );
+
+	// Рисует сглаженный отрезок в пределах прямоугольника плитки
+	void drawLine( int index, int left, int top, int right, int bottom );
+
+	// Смешивает пиксель с цветом по степени покрытия coverage, если он не закрыт более близким треугольником
+	void blendPixel( int x, int y, double depth, unsigned int color, double coverage );
+
+	double pointDepth( int index ) const;
+};
@@ -0,0 +1,317 @@
+﻿#pragma once
+#include <cmath>
+#include "3DPoint.h"
+
+/*
+* Векторы и матрицы фиксированного размера для движка. Всё определено в заголовке, чтобы компилятор мог
+* встраивать и векторизовать вычисления. Матрицы действуют на векторы-строки (v * M), как и CMatrix44.
+*/
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define VECTOR_MATH_USE_SSE2
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR_MATH_USE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#define VECTOR_MATH_ALIGN __declspec(align(16))
+#else
+#define VECTOR_MATH_ALIGN __attribute__((aligned(16)))
+#endif
+
+// VS2013 не поддерживает constexpr
+#if !defined(_MSC_VER) || _MSC_VER >= 1900
+#define VECTOR_MATH_CONSTEXPR constexpr
+#else
+#define VECTOR_MATH_CONSTEXPR
+#endif
+
+#ifdef VECTOR_MATH_USE_SSE2
+// Пары координат загружаются без требования выравнивания: под x86 объекты в куче выровнены только на 8 байт,
+// а на выровненных данных такая загрузка не медленнее
+#define VECTOR_MATH_LOAD( pointer ) _mm_loadu_pd( pointer )
+#define VECTOR_MATH_STORE( pointer, value ) _mm_storeu_pd( pointer, value )
+#endif
+
+// Трёхмерный вектор. Четвёртая координата дополняет его до двух пар для SIMD и всегда равна нулю
+struct VECTOR_MATH_ALIGN CVec3
+{
+	double X, Y, Z, W;
+
+	VECTOR_MATH_CONSTEXPR CVec3() : X( 0 ), Y( 0 ), Z( 0 ), W( 0 ) {}
+	VECTOR_MATH_CONSTEXPR CVec3( double x, double y, double z ) : X( x ), Y( y ), Z( z ), W( 0 ) {}
+
+	// Совместимость с C3DPoint
+	explicit CVec3( const C3DPoint& point ) : X( point.X ), Y( point.Y ), Z( point.Z ), W( 0 ) {}
+	C3DPoint ToPoint() const { return C3DPoint( X, Y, Z ); }
+
+#ifdef VECTOR_MATH_USE_SSE2
+	CVec3 operator+( const CVec3& other ) const
+	{
+		CVec3 result;
+		VECTOR_MATH_STORE( &result.X, _mm_add_pd( VECTOR_MATH_LOAD( &X ), VECTOR_MATH_LOAD( &other.X ) ) );
+		VECTOR_MATH_STORE( &result.Z, _mm_add_pd( VECTOR_MATH_LOAD( &Z ), VECTOR_MATH_LOAD( &other.Z ) ) );
+		return result;
+	}
+	CVec3 operator-( const CVec3& other ) const
+	{
+		CVec3 result;
+		VECTOR_MATH_STORE( &result.X, _mm_sub_pd( VECTOR_MATH_LOAD( &X ), VECTOR_MATH_LOAD( &other.X ) ) );
+		VECTOR_MATH_STORE( &result.Z, _mm_sub_pd( VECTOR_MATH_LOAD( &Z ), VECTOR_MATH_LOAD( &other.Z ) ) );
+		return result;
+	}
+	CVec3 operator*( double value ) const
+	{
+		const __m128d factor = _mm_set1_pd( value );
+		CVec3 result;
+		VECTOR_MATH_STORE( &result.X, _mm_mul_pd( VECTOR_MATH_LOAD( &X ), factor ) );
+		VECTOR_MATH_STORE( &result.Z, _mm_mul_pd( VECTOR_MATH_LOAD( &Z ), factor ) );
+		return result;
+	}
+	double Dot( const CVec3& other ) const
+	{
+		const __m128d products = _mm_add_pd( _mm_mul_pd( VECTOR_MATH_LOAD( &X ), VECTOR_MATH_LOAD( &other.X ) ),
+			_mm_mul_pd( VECTOR_MATH_LOAD( &Z ), VECTOR_MATH_LOAD( &other.Z ) ) );
+		return _mm_cvtsd_f64( _mm_add_sd( products, _mm_unpackhi_pd( products, products ) ) );
+	}
+#else
+	CVec3 operator+( const CVec3& other ) const { return CVec3( X + other.X, Y + other.Y, Z + other.Z ); }
+	CVec3 operator-( const CVec3& other ) const { return CVec3( X - other.X, Y - other.Y, Z - other.Z ); }
+	CVec3 operator*( double value ) const { return CVec3( X * value, Y * value, Z * value ); }
+	double Dot( const CVec3& other ) const { return X * other.X + Y * other.Y + Z * other.Z; }
+#endif
+
+	CVec3 operator/( double value ) const { return *this * ( 1 / value ); }
+	CVec3 operator-() const { return CVec3( -X, -Y, -Z ); }
+	void operator+=( const CVec3& other ) { *this = *this + other; }
+	void operator-=( const CVec3& other ) { *this = *this - other; }
+	void operator*=( double value ) { *this = *this * value; }
+
+	CVec3 Cross( const CVec3& other ) const
+	{
+		return CVec3( Y * other.Z - Z * other.Y, Z * other.X - X * other.Z, X * other.Y - Y * other.X );
+	}
+	double Length() const { return std::sqrt( Dot( *this ) ); }
+	// Возвращает нормализованный вектор
+	CVec3 Normalize() const
+	{
+		const double length = Length();
+		if( length < 1e-9 ) {
+			throw CVec3::NullLength();
+		}
+		return *this / length;
+	}
+
+	// Исключение при нормализации вектора нулевой длины
+	class NullLength {};
+};
+
+inline CVec3 operator*( double value, const CVec3& vector )
+{
+	return vector * value;
+}
+
+// Четырёхмерный вектор (однородные координаты)
+struct VECTOR_MATH_ALIGN CVec4
+{
+	double X, Y, Z, W;
+
+	VECTOR_MATH_CONSTEXPR CVec4() : X( 0 ), Y( 0 ), Z( 0 ), W( 0 ) {}
+	VECTOR_MATH_CONSTEXPR CVec4( double x, double y, double z, double w ) : X( x ), Y( y ), Z( z ), W( w ) {}
+	// Точка (w = 1) или направление (w = 0)
+	CVec4( const CVec3& vector, double w ) : X( vector.X ), Y( vector.Y ), Z( vector.Z ), W( w ) {}
+
+	CVec3 XYZ() const { return CVec3( X, Y, Z ); }
+
+#ifdef VECTOR_MATH_USE_SSE2
+	CVec4 operator+( const CVec4& other ) const
+	{
+		CVec4 result;
+		VECTOR_MATH_STORE( &result.X, _mm_add_pd( VECTOR_MATH_LOAD( &X ), VECTOR_MATH_LOAD( &other.X ) ) );
+		VECTOR_MATH_STORE( &result.Z, _mm_add_pd( VECTOR_MATH_LOAD( &Z ), VECTOR_MATH_LOAD( &other.Z ) ) );
+		return result;
+	}
+	CVec4 operator*( double value ) const
+	{
+		const __m128d factor = _mm_set1_pd( value );
+		CVec4 result;
+		VECTOR_MATH_STORE( &result.X, _mm_mul_pd( VECTOR_MATH_LOAD( &X ), factor ) );
+		VECTOR_MATH_STORE( &result.Z, _mm_mul_pd( VECTOR_MATH_LOAD( &Z ), factor ) );
+		return result;
+	}
+#else
+	CVec4 operator+( const CVec4& other ) const { return CVec4( X + other.X, Y + other.Y, Z + other.Z, W + other.W ); }
+	CVec4 operator*( double value ) const { return CVec4( X * value, Y * value, Z * value, W * value ); }
+#endif
+
+	double Dot( const CVec4& other ) const { return X * other.X + Y * other.Y + Z * other.Z + W * other.W; }
+};
+
+// Матрица 4x4, хранящаяся по строкам
+struct VECTOR_MATH_ALIGN CMat4
+{
+	double M[4][4];
+
+	// Единичная матрица
+	CMat4()
+	{
+		for( int i = 0; i < 4; i++ ) {
+			for( int j = 0; j < 4; j++ ) {
+				M[i][j] = i == j ? 1 : 0;
+			}
+		}
+	}
+	// Матрица из строк
+	CMat4( const CVec4& row0, const CVec4& row1, const CVec4& row2, const CVec4& row3 )
+	{
+		SetRow( 0, row0 );
+		SetRow( 1, row1 );
+		SetRow( 2, row2 );
+		SetRow( 3, row3 );
+	}
+
+	// Доступ к элементам без проверки границ
+	double Get( int row, int column ) const { return M[row][column]; }
+	void Set( int row, int column, double value ) { M[row][column] = value; }
+	CVec4 Row( int row ) const { return CVec4( M[row][0], M[row][1], M[row][2], M[row][3] ); }
+	void SetRow( int row, const CVec4& value )
+	{
+		M[row][0] = value.X;
+		M[row][1] = value.Y;
+		M[row][2] = value.Z;
+		M[row][3] = value.W;
+	}
+
+	// Произведение матриц: сначала применяется эта матрица, затем other
+	CMat4 operator*( const CMat4& other ) const
+	{
+		CMat4 result;
+		for( int i = 0; i < 4; i++ ) {
+			result.SetRow( i, other.Row( 0 ) * M[i][0] + other.Row( 1 ) * M[i][1] + other.Row( 2 ) * M[i][2] +
+				other.Row( 3 ) * M[i][3] );
+		}
+		return result;
+	}
+
+	// Умножает точку (w = 1) на матрицу
+	CVec3 TransformPoint( const CVec3& point ) const
+	{
+#ifdef VECTOR_MATH_USE_SSE2
+		const __m128d x = _mm_set1_pd( point.X );
+		const __m128d y = _mm_set1_pd( point.Y );
+		const __m128d z = _mm_set1_pd( point.Z );
+		CVec3 result;
+		VECTOR_MATH_STORE( &result.X, _mm_add_pd( _mm_add_pd( _mm_mul_pd( x, VECTOR_MATH_LOAD( &M[0][0] ) ),
+			_mm_mul_pd( y, VECTOR_MATH_LOAD( &M[1][0] ) ) ),
+			_mm_add_pd( _mm_mul_pd( z, VECTOR_MATH_LOAD( &M[2][0] ) ), VECTOR_MATH_LOAD( &M[3][0] ) ) ) );
+		result.Z = point.X * M[0][2] + point.Y * M[1][2] + point.Z * M[2][2] + M[3][2];
+		return result;
+#else
+		return CVec3(
+			point.X * M[0][0] + point.Y * M[1][0] + point.Z * M[2][0] + M[3][0],
+			point.X * M[0][1] + point.Y * M[1][1] + point.Z * M[2][1] + M[3][1],
+			point.X * M[0][2] + point.Y * M[1][2] + point.Z * M[2][2] + M[3][2] );
+#endif
+	}
+
+	// Умножает направление (w = 0) на матрицу: перенос не учитывается
+	CVec3 TransformVector( const CVec3& vector ) const
+	{
+		return CVec3(
+			vector.X * M[0][0] + vector.Y * M[1][0] + vector.Z * M[2][0],
+			vector.X * M[0][1] + vector.Y * M[1][1] + vector.Z * M[2][1],
+			vector.X * M[0][2] + vector.Y * M[1][2] + vector.Z * M[2][2] );
+	}
+
+	// Пакетное умножение точек, заданных раздельными массивами координат. Выходные массивы могут совпадать с входными
+	void TransformPoints( const double* x, const double* y, const double* z,
+		double* outX, double* outY, double* outZ, int count ) const
+	{
+		int i = 0;
+#if defined(__AVX__)
+		// Четыре точки за раз: каждый элемент матрицы размножается на четвёрку
+		__m256d m[4][3];
+		for( int row = 0; row < 4; row++ ) {
+			for( int column = 0; column < 3; column++ ) {
+				m[row][column] = _mm256_set1_pd( M[row][column] );
+			}
+		}
+		for( ; i + 4 <= count; i += 4 ) {
+			const __m256d px = _mm256_loadu_pd( x + i );
+			const __m256d py = _mm256_loadu_pd( y + i );
+			const __m256d pz = _mm256_loadu_pd( z + i );
+			__m256d result[3];
+			for( int column = 0; column < 3; column++ ) {
+				result[column] = _mm256_add_pd(
+					_mm256_add_pd( _mm256_mul_pd( px, m[0][column] ), _mm256_mul_pd( py, m[1][column] ) ),
+					_mm256_add_pd( _mm256_mul_pd( pz, m[2][column] ), m[3][column] ) );
+			}
+			_mm256_storeu_pd( outX + i, result[0] );
+			_mm256_storeu_pd( outY + i, result[1] );
+			_mm256_storeu_pd( outZ + i, result[2] );
+		}
+#elif defined(VECTOR_MATH_USE_SSE2)
+		// Две точки за раз: каждый элемент матрицы размножается на пару
+		__m128d m[4][3];
+		for( int row = 0; row < 4; row++ ) {
+			for( int column = 0; column < 3; column++ ) {
+				m[row][column] = _mm_set1_pd( M[row][column] );
+			}
+		}
+		for( ; i + 2 <= count; i += 2 ) {
+			const __m128d px = VECTOR_MATH_LOAD( x + i );
+			const __m128d py = VECTOR_MATH_LOAD( y + i );
+			const __m128d pz = VECTOR_MATH_LOAD( z + i );
+			__m128d result[3];
+			for( int column = 0; column < 3; column++ ) {
+				result[column] = _mm_add_pd(
+					_mm_add_pd( _mm_mul_pd( px, m[0][column] ), _mm_mul_pd( py, m[1][column] ) ),
+					_mm_add_pd( _mm_mul_pd( pz, m[2][column] ), m[3][column] ) );
+			}
+			VECTOR_MATH_STORE( outX + i, result[0] );
+			VECTOR_MATH_STORE( outY + i, result[1] );
+			VECTOR_MATH_STORE( outZ + i, result[2] );
+		}
+#endif
+		// Оставшиеся точки (или все, если векторные инструкции недоступны)
+		for( ; i < count; i++ ) {
+			const double px = x[i];
+			const double py = y[i];
+			const double pz = z[i];
+			outX[i] = px * M[0][0] + py * M[1][0] + pz * M[2][0] + M[3][0];
+			outY[i] = px * M[0][1] + py * M[1][1] + pz * M[2][1] + M[3][1];
+			outZ[i] = px * M[0][2] + py * M[1][2] + pz * M[2][2] + M[3][2];
+		}
+	}
+
+	// Поворот на угол angle вокруг оси axis (единичный вектор) по правилу правой руки
+	static CMat4 Rotation( const CVec3& axis, double angle )
+	{
+		const double cosTheta = std::cos( angle );
+		const double sinTheta = std::sin( angle );
+		const double x = axis.X;
+		const double y = axis.Y;
+		const double z = axis.Z;
+		// Формула Родрига, транспонированная под умножение вектора-строки слева
+		return CMat4(
+			CVec4( cosTheta + ( 1 - cosTheta ) * x * x, ( 1 - cosTheta ) * x * y + z * sinTheta,
+				( 1 - cosTheta ) * x * z - y * sinTheta, 0 ),
+			CVec4( ( 1 - cosTheta ) * x * y - z * sinTheta, cosTheta + ( 1 - cosTheta ) * y * y,
+				( 1 - cosTheta ) * y * z + x * sinTheta, 0 ),
+			CVec4( ( 1 - cosTheta ) * x * z + y * sinTheta, ( 1 - cosTheta ) * y * z - x * sinTheta,
+				cosTheta + ( 1 - cosTheta ) * z * z, 0 ),
+			CVec4( 0, 0, 0, 1 ) );
+	}
+
+	// Переход в систему координат с началом origin и ортонормированными осями right, up, forward
+	static CMat4 View( const CVec3& origin, const CVec3& right, const CVec3& up, const CVec3& forward )
+	{
+		return CMat4(
+			CVec4( right.X, up.X, forward.X, 0 ),
+			CVec4( right.Y, up.Y, forward.Y, 0 ),
+			CVec4( right.Z, up.Z, forward.Z, 0 ),
+			CVec4( -origin.Dot( right ), -origin.Dot( up ), -origin.Dot( forward ), 1 ) );
+	}
+};
@@ -13,6 +13,7 @@ bool CGraphBuilder::buildPointGrid( const CFormula& formula, std::map< char, std
 	try {
 		points.clear();
 		segments.clear();
+		levels.clear();
 		std::vector<char> vars = formula.GetVariables();
 
 		std::map< char, double > argToCount;
@@ -25,6 +26,7 @@ bool CGraphBuilder::buildPointGrid( const CFormula& formula, std::map< char, std
 					segments.push_back( std::make_pair( points.size() - 1, points.size() - 2 ) );
 				}
 			}
+			buildLevels( static_cast<int>( points.size() ), 1 );
 		} else if( vars.size() == 2 ) {//TODO сделать циклы для argToCount
 			// не очень красиво вносить это в циклы.
 			int secondAxisSize = static_cast<int>( ( args[vars[1]].second - args[vars[1]].first ) / eps ); 
@@ -43,7 +45,7 @@ bool CGraphBuilder::buildPointGrid( const CFormula& formula, std::map< char, std
 					}
 				}
 			}
-			
+			buildLevels( firstAxisSize, secondAxisSize );
 		} else {
 			return false;
 		}
@@ -53,4 +55,61 @@ bool CGraphBuilder::buildPointGrid( const CFormula& formula, std::map< char, std
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+const std::vector< C3DPoint >& CGraphBuilder::GetLevelPoints( int level ) const
+{
+	assert( level >= 0 && level < GetLevelsCount() );
+	return level == 0 ? points : levels[level - 1].Points;
+}
+
+const std::vector< std::pair< int, int > >& CGraphBuilder::GetLevelSegments( int level ) const
+{
+	assert( level >= 0 && level < GetLevelsCount() );
+	return level == 0 ? segments : levels[level - 1].Segments;
+}
+
+// Номера точек оси, попадающих на уровень с шагом step: каждая step-я и последняя
+static std::vector< int > sampleAxis( int size, int step )
+{
+	std::vector< int > samples;
+	for( int i = 0; i < size; i += step ) {
+		samples.push_back( i );
+	}
+	if( size > 0 && samples.back() != size - 1 ) {
+		samples.push_back( size - 1 );
+	}
+	return samples;
+}
+
+void CGraphBuilder::buildLevels( int firstAxisSize, int secondAxisSize )
+{
+	int previousPointsCount = static_cast<int>( points.size() );
+	for( int step = 2; ; step *= 2 ) {
+		const std::vector< int > firstSamples = sampleAxis( firstAxisSize, step );
+		const std::vector< int > secondSamples = sampleAxis( secondAxisSize, step );
+		const int pointsCount = static_cast<int>( firstSamples.size() * secondSamples.size() );
+		// Прореживать дальше некуда
+		if( pointsCount == previousPointsCount || pointsCount < 2 ) {
+			break;
+		}
+		previousPointsCount = pointsCount;
+
+		levels.push_back( CGridLevel() );
+		CGridLevel& level = levels.back();
+		level.Points.reserve( pointsCount );
+		const int secondSize = static_cast<int>( secondSamples.size() );
+		for( int i = 0; i < static_cast<int>( firstSamples.size() ); i++ ) {
+			for( int j = 0; j < secondSize; j++ ) {
+				level.Points.push_back( points[firstSamples[i] * secondAxisSize + secondSamples[j]] );
+				const int index = static_cast<int>( level.Points.size() ) - 1;
+				if( j > 0 ) {
+					level.Segments.push_back( std::make_pair( index, index - 1 ) );
+				}
+				if( i > 0 ) {
+					level.Segments.push_back( std::make_pair( index, index - secondSize ) );
+				}
+			}
+		}
+	}
+}
@@ -20,7 +20,24 @@ public:
 	// getters
 	const std::vector< C3DPoint >& GetPoints() const { return points; }
 	const std::vector< std::pair< int, int > >& GetSegments() const { return segments; }
+
+	// Уровни детализации сетки: уровень 0 - сама сетка, на уровне k берётся каждая 2^k-я точка по каждой оси
+	// (и последняя, чтобы сохранить границы графика). Строятся вместе с сеткой
+	int GetLevelsCount() const { return static_cast<int>( levels.size() ) + 1; }
+	const std::vector< C3DPoint >& GetLevelPoints( int level ) const;
+	const std::vector< std::pair< int, int > >& GetLevelSegments( int level ) const;
 private:
 	std::vector< C3DPoint > points;
 	std::vector< std::pair< int, int > > segments;
+
+	// Прореженные сетки, начиная с уровня 1
+	struct CGridLevel {
+		std::vector< C3DPoint > Points;
+		std::vector< std::pair< int, int > > Segments;
+	};
+	std::vector< CGridLevel > levels;
+
+	// Строит уровни детализации по сетке размером firstAxisSize x secondAxisSize (точка (i, j) имеет номер
+	// i * secondAxisSize + j)
+	void buildLevels( int firstAxisSize, int secondAxisSize );
 };
\ No newline at end of file